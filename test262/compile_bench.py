@@ -0,0 +1,309 @@
+#!/usr/bin/python3
+# coding: utf-8
+
+"""
+Copyright (c) 2021 Huawei Device Co., Ltd.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Description: Measure the compile throughput of the ts2panda -> ts2abc pipeline
+"""
+
+import hashlib
+import json
+import os
+import platform
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from utils import *
+from config import *
+
+BENCH_OPT_LEVELS = [0, 1, 2]
+BENCH_REPEAT = 3
+BENCH_TIME_THRESHOLD = 0.10
+BENCH_RSS_THRESHOLD = 0.10
+BENCH_SIZE_THRESHOLD = 0.01
+BENCH_OUT_DIR = os.path.join(BASE_OUT_DIR, "compile_bench")
+
+# the whole pipeline, ts2abc alone replaying the recorded piece stream, and the difference
+PHASE_PIPELINE = "pipeline"
+PHASE_TS2ABC = "ts2abc"
+PHASE_FRONTEND = "frontend"
+
+
+def add_bench_args(parser):
+    parser.add_argument('--compile-bench', action='store_true',
+                        help="Measure compile time, memory and .abc size "
+                        "instead of executing the tests")
+    parser.add_argument('--bench-opt-levels', default=",".join(
+                        str(level) for level in BENCH_OPT_LEVELS),
+                        help="Comma separated optimization levels to measure")
+    parser.add_argument('--bench-repeat', default=BENCH_REPEAT, type=int,
+                        help="Measured runs per file, the median is kept")
+    parser.add_argument('--bench-output', metavar='FILE',
+                        help="Store the results as json in this file")
+    parser.add_argument('--bench-baseline', metavar='FILE',
+                        help="Compare the results with a stored result file")
+    parser.add_argument('--bench-time-threshold', default=BENCH_TIME_THRESHOLD,
+                        type=float, help="Allowed relative growth of wall and cpu time")
+    parser.add_argument('--bench-rss-threshold', default=BENCH_RSS_THRESHOLD,
+                        type=float, help="Allowed relative growth of peak RSS")
+    parser.add_argument('--bench-size-threshold', default=BENCH_SIZE_THRESHOLD,
+                        type=float, help="Allowed relative growth of the .abc size")
+    parser.add_argument('--ark-ts2abc-tool',
+                        help="ts2abc binary, by default the js2abc next to the frontend")
+
+
+def measure(cmd_args, timeout=DEFAULT_TIMEOUT):
+    # wait4 reports the usage of this child and of the children it waited for,
+    # so js2abc is accounted to the node process that spawned it
+    errs_file = tempfile.TemporaryFile()
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd_args, stdout=subprocess.DEVNULL,
+                            stderr=errs_file, close_fds=True)
+    deadline = start + timeout / 1000
+    while True:
+        pid, status, usage = os.wait4(proc.pid, os.WNOHANG)
+        if pid != 0:
+            break
+        if time.perf_counter() > deadline:
+            proc.kill()
+            os.wait4(proc.pid, 0)
+            proc.returncode = -signal.SIGKILL
+            errs_file.close()
+            return None, f"Timeout: '{' '.join(cmd_args)}'"
+        time.sleep(0.001)
+    wall_time = time.perf_counter() - start
+    if os.WIFSIGNALED(status):
+        proc.returncode = -os.WTERMSIG(status)
+    else:
+        proc.returncode = os.WEXITSTATUS(status)
+    errs_file.seek(0)
+    errs = errs_file.read().decode('utf-8', 'ignore')
+    errs_file.close()
+
+    if proc.returncode != 0:
+        return None, f"'{' '.join(cmd_args)}' failed: {errs}"
+
+    return {
+        "wall_time": wall_time,
+        "cpu_time": usage.ru_utime + usage.ru_stime,
+        # kilobytes on linux
+        "peak_rss_kb": usage.ru_maxrss
+    }, errs
+
+
+def median_sample(samples):
+    return {
+        "wall_time": statistics.median(s["wall_time"] for s in samples),
+        "cpu_time": statistics.median(s["cpu_time"] for s in samples),
+        "peak_rss_kb": max(s["peak_rss_kb"] for s in samples)
+    }
+
+
+def empty_phase():
+    return {"wall_time": 0.0, "cpu_time": 0.0, "peak_rss_kb": 0}
+
+
+def accumulate(total, sample):
+    total["wall_time"] += sample["wall_time"]
+    total["cpu_time"] += sample["cpu_time"]
+    total["peak_rss_kb"] = max(total["peak_rss_kb"], sample["peak_rss_kb"])
+
+
+def corpus_digest(files):
+    digest = hashlib.sha256()
+    size = 0
+    for file in files:
+        with open(file, 'rb') as source:
+            content = source.read()
+        digest.update(file.encode('utf-8'))
+        digest.update(content)
+        size += len(content)
+    return digest.hexdigest(), size
+
+
+class CompileBench():
+    def __init__(self, args, files):
+        self.args = args
+        self.files = sorted(files)
+        self.frontend_tool = args.ark_frontend_tool or DEFAULT_ARK_FRONTEND_TOOL
+        self.ts2abc_tool = args.ark_ts2abc_tool or os.path.join(
+            os.path.dirname(os.path.dirname(os.path.realpath(self.frontend_tool))),
+            "bin", "js2abc")
+        self.opt_levels = [int(level) for level in args.bench_opt_levels.split(",")]
+        self.repeat = max(1, args.bench_repeat)
+        self.out_dir = BENCH_OUT_DIR
+
+    def frontend_cmd(self, js_file, out_file, opt_level, record):
+        cmd_args = ['node', '--expose-gc', self.frontend_tool, js_file,
+                    '-o', out_file, '--opt-level', str(opt_level)]
+        if record:
+            # a fresh --incremental build leaves the full piece stream in <out>.pieces
+            cmd_args.append('--incremental')
+        if os.path.basename(js_file) in MODULE_FILES_LIST:
+            cmd_args.append('-m')
+        return cmd_args
+
+    def bench_file(self, js_file, opt_level, result):
+        name = os.path.splitext(os.path.basename(js_file))[0]
+        out_file = os.path.join(self.out_dir, f"{name}.O{opt_level}.abc")
+        pieces_file = f"{out_file}.pieces"
+        replay_file = os.path.join(self.out_dir, f"{name}.O{opt_level}.replay.abc")
+        remove_file(out_file)
+        remove_file(pieces_file)
+
+        # the first run warms up the file cache and records the stream for ts2abc
+        sample, msg = measure(self.frontend_cmd(js_file, out_file, opt_level, True))
+        if sample is None or not os.path.exists(pieces_file):
+            result["failed"].append({"file": js_file, "error": msg})
+            return
+
+        pipeline = []
+        ts2abc = []
+        for _ in range(self.repeat):
+            sample, msg = measure(self.frontend_cmd(js_file, out_file, opt_level, False))
+            if sample is None:
+                result["failed"].append({"file": js_file, "error": msg})
+                return
+            pipeline.append(sample)
+
+            sample, msg = measure([self.ts2abc_tool, pieces_file, replay_file,
+                                   '--opt-level', str(opt_level)])
+            if sample is None:
+                result["failed"].append({"file": js_file, "error": msg})
+                return
+            ts2abc.append(sample)
+
+        pipeline = median_sample(pipeline)
+        ts2abc = median_sample(ts2abc)
+        frontend = {
+            "wall_time": max(0.0, pipeline["wall_time"] - ts2abc["wall_time"]),
+            "cpu_time": max(0.0, pipeline["cpu_time"] - ts2abc["cpu_time"]),
+            # node is the larger of the two processes, its peak is the pipeline peak
+            "peak_rss_kb": pipeline["peak_rss_kb"]
+        }
+        accumulate(result["phases"][PHASE_PIPELINE], pipeline)
+        accumulate(result["phases"][PHASE_TS2ABC], ts2abc)
+        accumulate(result["phases"][PHASE_FRONTEND], frontend)
+        result["abc_size"] += os.path.getsize(out_file)
+        result["files"] += 1
+
+        remove_file(pieces_file)
+        remove_file(replay_file)
+
+    def run(self):
+        if not hasattr(os, "wait4"):
+            sys.stderr.write("compile benchmark needs os.wait4, which "
+                             f"is not available on {platform.system()}\n")
+            return None
+
+        mkdir(self.out_dir)
+        digest, size = corpus_digest(self.files)
+        results = {
+            "timestamp": current_time(),
+            "frontend": self.frontend_tool,
+            "ts2abc": self.ts2abc_tool,
+            "repeat": self.repeat,
+            "corpus": {"files": len(self.files), "bytes": size, "digest": digest},
+            "opt_levels": {}
+        }
+
+        for opt_level in self.opt_levels:
+            result = {
+                "files": 0,
+                "abc_size": 0,
+                "phases": {phase: empty_phase() for phase in
+                           [PHASE_PIPELINE, PHASE_FRONTEND, PHASE_TS2ABC]},
+                "failed": []
+            }
+            for js_file in self.files:
+                self.bench_file(js_file, opt_level, result)
+            results["opt_levels"][str(opt_level)] = result
+            LOGGING.info(f"opt-level {opt_level}: {result['files']} files, "
+                         f"{len(result['failed'])} failed, "
+                         f"{result['abc_size']} bytes of abc")
+
+        return results
+
+
+def print_results(results):
+    header = f"{'opt':<4}{'phase':<10}{'wall(s)':>10}{'cpu(s)':>10}{'rss(KB)':>10}"
+    print(header)
+    for opt_level, result in results["opt_levels"].items():
+        for phase, sample in result["phases"].items():
+            print(f"{opt_level:<4}{phase:<10}{sample['wall_time']:>10.3f}"
+                  f"{sample['cpu_time']:>10.3f}{sample['peak_rss_kb']:>10}")
+        print(f"{opt_level:<4}{'abc size':<10}{result['abc_size']:>30}")
+
+
+def check_metric(regressions, name, current, baseline, threshold):
+    if baseline <= 0:
+        return
+    growth = (current - baseline) / baseline
+    if growth > threshold:
+        regressions.append(f"{name}: {baseline} -> {current} "
+                           f"(+{growth * 100:.1f}%, threshold {threshold * 100:.1f}%)")
+
+
+def compare_results(results, baseline, args):
+    regressions = []
+    if results["corpus"]["digest"] != baseline["corpus"]["digest"]:
+        sys.stderr.write("warning: the corpus differs from the baseline corpus\n")
+
+    thresholds = {
+        "wall_time": args.bench_time_threshold,
+        "cpu_time": args.bench_time_threshold,
+        "peak_rss_kb": args.bench_rss_threshold
+    }
+    for opt_level, result in results["opt_levels"].items():
+        base = baseline["opt_levels"].get(opt_level)
+        if base is None:
+            continue
+        for phase, sample in result["phases"].items():
+            base_sample = base["phases"].get(phase, {})
+            for metric, threshold in thresholds.items():
+                if metric in base_sample:
+                    check_metric(regressions, f"O{opt_level} {phase} {metric}",
+                                 sample[metric], base_sample[metric], threshold)
+        check_metric(regressions, f"O{opt_level} abc_size", result["abc_size"],
+                     base["abc_size"], args.bench_size_threshold)
+        if len(result["failed"]) > len(base["failed"]):
+            regressions.append(f"O{opt_level}: {len(result['failed'])} files failed "
+                               f"to compile, baseline {len(base['failed'])}")
+    return regressions
+
+
+def run_compile_bench(args, files):
+    bench = CompileBench(args, files)
+    results = bench.run()
+    if results is None:
+        return 1
+
+    print_results(results)
+    if args.bench_output:
+        with open(args.bench_output, 'w') as output:
+            json.dump(results, output, indent=2)
+
+    if not args.bench_baseline:
+        return 0
+
+    with open(args.bench_baseline) as baseline_file:
+        baseline = json.load(baseline_file)
+    regressions = compare_results(results, baseline, args)
+    for regression in regressions:
+        sys.stderr.write(f"{TERM_RED}regression: {regression}{TERM_NORMAL}\n")
+    return 1 if regressions else 0
@@ -26,6 +26,7 @@ import signal
 import subprocess
 from utils import *
 from config import *
+from compile_bench import add_bench_args, run_compile_bench
 
 
 def parse_args():
@@ -41,6 +42,7 @@ def parse_args():
     parser.add_argument('--ark-frontend',
                         nargs='?', choices=ARK_FRONTEND_LIST, type=str,
                         help="Choose one of them")
+    add_bench_args(parser)
     arguments = parser.parse_args()
     return arguments
 
@@ -179,9 +181,24 @@ class ArkProgram():
         self.execute()
 
 
+def collect_js_files(path):
+    if os.path.isfile(path):
+        return [path]
+
+    files = []
+    for root, _, file_names in os.walk(path):
+        files.extend(os.path.join(root, file_name) for file_name in file_names
+                     if file_name.endswith(".js"))
+    return files
+
+
 def main():
     args = parse_args()
 
+    if args.compile_bench:
+        # --js-file may name a whole directory of benchmarks here
+        return run_compile_bench(args, collect_js_files(args.js_file))
+
     ark = ArkProgram(args)
     ark.execute_ark()
 
@@ -28,6 +28,7 @@ import subprocess
 from multiprocessing import Pool
 from utils import *
 from config import *
+from compile_bench import add_bench_args, run_compile_bench
 
 
 def parse_args():
@@ -72,6 +73,7 @@ def parse_args():
     parser.add_argument('--ark-frontend',
                         nargs='?', choices=ARK_FRONTEND_LIST, type=str,
                         help="Choose one of them")
+    add_bench_args(parser)
     return parser.parse_args()
 
 
@@ -441,6 +443,18 @@ def run_test262_test(args):
     run_check(test_cmd)
 
 
+def run_test262_compile_bench(args):
+    if args.ark_frontend and args.ark_frontend != DEFAULT_ARK_FRONTEND:
+        sys.stderr.write("compile benchmark only supports the ts2panda frontend\n")
+        return 1
+
+    if args.file:
+        files = [args.file]
+    else:
+        files = list(collect_files(args.dir))
+    return run_compile_bench(args, files)
+
+
 Check = collections.namedtuple('Check', ['enabled', 'runner', 'arg'])
 
 
@@ -448,7 +462,10 @@ def main(args):
     print("\nWait a moment..........\n")
     starttime = datetime.datetime.now()
     run_test262_prepare(args)
-    check = Check(True, run_test262_test, args)
+    if args.compile_bench:
+        check = Check(True, run_test262_compile_bench, args)
+    else:
+        check = Check(True, run_test262_test, args)
     ret = check.runner(check.arg)
     if ret:
         sys.exit(ret)
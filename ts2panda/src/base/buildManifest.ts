@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import * as crypto from "crypto";
+import * as fs from "fs";
+import * as path from "path";
+import * as ts from "typescript";
+import { LOGD } from "../log";
+
+const MANIFEST_FORMAT = 1;
+
+export interface BuildEntry {
+    hash: string;
+    output: string;
+    // resolved file name -> content hash, of every file the source imports or re-exports from
+    deps: { [fileName: string]: string };
+}
+
+interface Manifest {
+    format: number;
+    toolVersion: string;
+    optionsHash: string;
+    files: { [fileName: string]: BuildEntry };
+}
+
+export function hashContent(content: string | Buffer): string {
+    return crypto.createHash("sha256").update(content).digest("hex");
+}
+
+function hashFile(fileName: string): string | undefined {
+    try {
+        return hashContent(fs.readFileSync(fileName));
+    } catch (err) {
+        return undefined;
+    }
+}
+
+// ts2panda and ts2abc as they are installed, a rebuild of either invalidates every output
+function getToolVersion(): string {
+    let tools = [path.join(path.resolve(__dirname, '../../bin'), "js2abc"), __filename];
+    return hashContent(tools.map((tool) => {
+        if (!fs.existsSync(tool)) {
+            return tool;
+        }
+        let stat = fs.statSync(tool);
+        return tool + ":" + stat.size + ":" + stat.mtime.getTime();
+    }).join("\n"));
+}
+
+/**
+ * Build information of the last successful build, kept next to the output. A source file is
+ * compiled again only when its content, the files it imports, the options or the tools changed,
+ * or when its output is gone.
+ */
+export class BuildManifest {
+    private static current: BuildManifest | undefined;
+    // outputs finished by this thread, a worker hands them to the main thread
+    private static built: Map<string, BuildEntry> = new Map<string, BuildEntry>();
+
+    readonly manifestFile: string;
+    private toolVersion: string;
+    private optionsHash: string;
+    private previous: { [fileName: string]: BuildEntry } = {};
+    private kept: Map<string, BuildEntry> = new Map<string, BuildEntry>();
+    private upToDate: Map<string, boolean> = new Map<string, boolean>();
+
+    constructor(manifestFile: string, outputOptions: string) {
+        this.manifestFile = manifestFile;
+        this.toolVersion = getToolVersion();
+        this.optionsHash = hashContent(outputOptions);
+        if (!fs.existsSync(manifestFile)) {
+            return;
+        }
+
+        try {
+            let manifest: Manifest = JSON.parse(fs.readFileSync(manifestFile, "utf-8"));
+            if (manifest.format == MANIFEST_FORMAT && manifest.toolVersion == this.toolVersion &&
+                manifest.optionsHash == this.optionsHash) {
+                this.previous = manifest.files;
+            } else {
+                LOGD("tools or options changed, rebuild everything");
+            }
+        } catch (err) {
+            LOGD("fail to load build info, rebuild everything: ", err);
+        }
+    }
+
+    static getCurrent(): BuildManifest | undefined {
+        return BuildManifest.current;
+    }
+
+    static setCurrent(manifest: BuildManifest) {
+        BuildManifest.current = manifest;
+        // the last ts2abc has exited by then
+        process.on('exit', () => manifest.save());
+    }
+
+    static createEntry(fileName: string, output: string, moduleRequests: string[],
+        options: ts.CompilerOptions): BuildEntry | undefined {
+        fileName = path.resolve(fileName);
+        let hash = hashFile(fileName);
+        if (hash === undefined) {
+            return undefined;
+        }
+
+        let deps: { [fileName: string]: string } = {};
+        moduleRequests.forEach((moduleRequest) => {
+            let resolved = ts.resolveModuleName(moduleRequest, fileName, options, ts.sys).resolvedModule;
+            if (resolved) {
+                deps[resolved.resolvedFileName] = hashFile(resolved.resolvedFileName) || "";
+            }
+        });
+        return { hash: hash, output: path.resolve(output), deps: deps };
+    }
+
+    static addBuilt(fileName: string, entry: BuildEntry) {
+        BuildManifest.built.set(fileName, entry);
+    }
+
+    static takeBuilt(): [string, BuildEntry][] {
+        let built: [string, BuildEntry][] = [];
+        BuildManifest.built.forEach((entry, fileName) => {
+            built.push([fileName, entry]);
+        });
+        BuildManifest.built.clear();
+        return built;
+    }
+
+    // the files of the last build
+    getFileNames(): string[] {
+        return Object.keys(this.previous);
+    }
+
+    isUpToDate(fileName: string): boolean {
+        fileName = path.resolve(fileName);
+        let cached = this.upToDate.get(fileName);
+        if (cached !== undefined) {
+            return cached;
+        }
+
+        let entry = this.previous[fileName];
+        if (!entry) {
+            return false;
+        }
+
+        // an import cycle only depends on the hashes checked below
+        this.upToDate.set(fileName, true);
+        let upToDate = fs.existsSync(entry.output) && hashFile(fileName) == entry.hash;
+        for (let dep in entry.deps) {
+            if (!upToDate) {
+                break;
+            }
+            upToDate = hashFile(dep) == entry.deps[dep] && (!this.previous[dep] || this.isUpToDate(dep));
+        }
+        this.upToDate.set(fileName, upToDate);
+        return upToDate;
+    }
+
+    // true when the last build covered 'fileNames' and none of its files is dirty
+    isAllUpToDate(fileNames: string[]): boolean {
+        let previousFiles = Object.keys(this.previous);
+        if (previousFiles.length == 0 || !fileNames.every((fileName) => this.previous[path.resolve(fileName)])) {
+            return false;
+        }
+        return previousFiles.every((fileName) => this.isUpToDate(fileName));
+    }
+
+    // keeps the outputs of the files which are up to date and returns the others
+    filterDirty(fileNames: string[]): string[] {
+        return fileNames.filter((fileName) => {
+            if (!this.isUpToDate(fileName)) {
+                return true;
+            }
+            LOGD("up to date: ", fileName);
+            this.keep(fileName);
+            return false;
+        });
+    }
+
+    keep(fileName: string) {
+        fileName = path.resolve(fileName);
+        this.kept.set(fileName, this.previous[fileName]);
+    }
+
+    keepAll() {
+        Object.keys(this.previous).forEach((fileName) => this.keep(fileName));
+    }
+
+    save() {
+        let files: { [fileName: string]: BuildEntry } = {};
+        this.kept.forEach((entry, fileName) => {
+            files[fileName] = entry;
+        });
+        BuildManifest.built.forEach((entry, fileName) => {
+            files[path.resolve(fileName)] = entry;
+        });
+
+        let manifest: Manifest = {
+            format: MANIFEST_FORMAT,
+            toolVersion: this.toolVersion,
+            optionsHash: this.optionsHash,
+            files: files
+        };
+
+        // write aside and rename, so that an interrupted build never leaves a truncated manifest
+        let tmpFile = this.manifestFile + ".tmp";
+        try {
+            fs.writeFileSync(tmpFile, JSON.stringify(manifest, null, 2));
+            fs.renameSync(tmpFile, this.manifestFile);
+        } catch (err) {
+            LOGD("fail to save build info: ", err);
+        }
+    }
+}
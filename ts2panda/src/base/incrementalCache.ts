@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import * as fs from "fs";
+import { LOGD } from "../log";
+
+const escapedDollarSign: RegExp = /#\$/g;
+
+/**
+ * Function pieces of the previous build, as stored by ts2abc next to the output file.
+ * A function whose piece is byte-identical to the cached one is not sent again,
+ * ts2abc takes it from the cache instead. The piece itself is still built, it is what
+ * is compared, so the saving is in the pipe and in the parsing done by ts2abc.
+ */
+export class IncrementalCache {
+    readonly cacheFile: string;
+    private baseFunctions: Map<string, string> = new Map<string, string>();
+    private seenFunctions: Set<string> = new Set<string>();
+
+    constructor(outputBinName: string) {
+        this.cacheFile = IncrementalCache.getCacheFile(outputBinName);
+        // without the output file the cache is useless, do a full build
+        if (!fs.existsSync(outputBinName) || !fs.existsSync(this.cacheFile)) {
+            return;
+        }
+
+        try {
+            this.load(fs.readFileSync(this.cacheFile, "utf-8"));
+        } catch (err) {
+            LOGD("fail to load incremental cache, do a full build: ", err);
+            this.baseFunctions.clear();
+        }
+    }
+
+    // the whole piece stream of the last successful build of 'outputBinName'
+    static getCacheFile(outputBinName: string): string {
+        return outputBinName + ".pieces";
+    }
+
+    private load(data: string) {
+        let start = -1;
+        for (let idx = 0; idx < data.length; idx++) {
+            if (data[idx] != '$' || (idx > 0 && data[idx - 1] == '#')) {
+                continue;
+            }
+
+            if (start < 0) {
+                start = idx + 1;
+                continue;
+            }
+
+            let piece = data.substring(start, idx);
+            let pieceObject = JSON.parse(piece.replace(escapedDollarSign, '$'));
+            if (pieceObject.func_body) {
+                this.baseFunctions.set(pieceObject.func_body.name, piece);
+            }
+            start = -1;
+        }
+    }
+
+    hasBase(): boolean {
+        return this.baseFunctions.size > 0;
+    }
+
+    // piece is the escaped json of one function without the surrounding '$'
+    isUnchanged(funcName: string, piece: string): boolean {
+        this.seenFunctions.add(funcName);
+        return this.baseFunctions.get(funcName) === piece;
+    }
+
+    getRemovedFunctions(): Array<string> {
+        let removed: Array<string> = [];
+        this.baseFunctions.forEach((piece: string, funcName: string) => {
+            if (!this.seenFunctions.has(funcName)) {
+                removed.push(funcName);
+            }
+        });
+
+        return removed;
+    }
+}
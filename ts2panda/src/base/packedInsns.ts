@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import {
+    Imm,
+    IRNode,
+    Label,
+    OperandType,
+    VReg
+} from "../irnodes";
+import { getRangeStartVregPos, isRangeInst } from "./util";
+
+// fields of one instruction in 'insns'
+const OP = 0;
+const OPERAND_BEGIN = 1;
+const OPERAND_END = 2;
+const LINE = 3;
+const COLUMN = 4;
+const BOUND_LEFT = 5;
+const BOUND_RIGHT = 6;
+const INS_FIELDS = 7;
+
+// a label takes the place of an opcode, its id is kept in OPERAND_BEGIN
+const OP_LABEL = -1;
+
+const enum OperandTag {
+    REG,
+    IMM,
+    ID,
+    LABEL
+}
+
+const INITIAL_INS_CAPACITY = 1024;
+const INITIAL_OPERAND_CAPACITY = 2048;
+
+export const LABEL_PREFIX = "LABEL_";
+
+function serializeNumber(value: number): string {
+    // the way JSON.stringify writes numbers
+    return isFinite(value) ? String(value) : "null";
+}
+
+/**
+ * The instructions of one function packed into typed arrays, from which the "ins" and "labels"
+ * of its piece are written directly. The buffers only grow and are reused for the next function,
+ * so serializing a function allocates nothing per instruction but the text itself.
+ */
+export class PackedInsns {
+    // json of each mnemonic, an opcode is an index into it
+    private static opNames: string[] = [];
+    private static opIndexes: Map<string, number> = new Map<string, number>();
+
+    private insns: Int32Array = new Int32Array(INITIAL_INS_CAPACITY * INS_FIELDS);
+    private insCount: number = 0;
+    private operandTags: Uint8Array = new Uint8Array(INITIAL_OPERAND_CAPACITY);
+    private operandValues: Float64Array = new Float64Array(INITIAL_OPERAND_CAPACITY);
+    private operandCount: number = 0;
+    // ids are indexed by the value of their operand
+    private ids: string[] = [];
+
+    private static getOpIndex(mnemonic: string): number {
+        let index = PackedInsns.opIndexes.get(mnemonic);
+        if (index === undefined) {
+            index = PackedInsns.opNames.length;
+            PackedInsns.opNames.push(JSON.stringify(mnemonic));
+            PackedInsns.opIndexes.set(mnemonic, index);
+        }
+        return index;
+    }
+
+    getInsCount(): number {
+        return this.insCount;
+    }
+
+    getIds(): string[] {
+        return this.ids;
+    }
+
+    // packs 'irNodes' in place of the previous function, once all passes have run on them
+    encode(irNodes: IRNode[]) {
+        this.insCount = 0;
+        this.operandCount = 0;
+        this.ids.length = 0;
+        this.reserveInsns(irNodes.length);
+        irNodes.forEach((irNode: IRNode) => this.append(irNode));
+    }
+
+    private append(irNode: IRNode) {
+        let base = this.insCount * INS_FIELDS;
+        let insns = this.insns;
+
+        if (irNode instanceof Label) {
+            insns[base + OP] = OP_LABEL;
+            insns[base + OPERAND_BEGIN] = irNode.id;
+            insns[base + OPERAND_END] = 0;
+        } else {
+            insns[base + OP] = PackedInsns.getOpIndex(irNode.mnemonic);
+            insns[base + OPERAND_BEGIN] = this.operandCount;
+            this.appendOperands(irNode);
+            insns[base + OPERAND_END] = this.operandCount;
+        }
+
+        let posInfo = irNode.debugPosInfo;
+        insns[base + LINE] = posInfo.getSourceLineNum();
+        insns[base + COLUMN] = posInfo.getSourceColumnNum();
+        insns[base + BOUND_LEFT] = posInfo.getBoundLeft() || 0;
+        insns[base + BOUND_RIGHT] = posInfo.getBoundRight() || 0;
+        this.insCount++;
+    }
+
+    private appendOperands(irNode: IRNode) {
+        let operands = irNode.operands;
+        this.reserveOperands(operands.length);
+
+        if (isRangeInst(irNode)) {
+            // for range instructions only the first vreg of the continuous ones is passed
+            this.appendOperand(OperandTag.IMM, (<Imm>operands[0]).value);
+            this.appendOperand(OperandTag.REG, (<VReg>operands[1]).num);
+            if (getRangeStartVregPos(irNode) == 2) {
+                this.appendOperand(OperandTag.REG, (<VReg>operands[2]).num);
+            }
+            return;
+        }
+
+        operands.forEach((operand: OperandType) => {
+            if (operand instanceof VReg) {
+                this.appendOperand(OperandTag.REG, operand.num);
+            } else if (operand instanceof Imm) {
+                this.appendOperand(OperandTag.IMM, operand.value);
+            } else if (typeof (operand) === "string") {
+                this.appendOperand(OperandTag.ID, this.ids.length);
+                this.ids.push(operand);
+            } else if (operand instanceof Label) {
+                this.appendOperand(OperandTag.LABEL, operand.id);
+            }
+        });
+    }
+
+    private appendOperand(tag: OperandTag, value: number) {
+        this.operandTags[this.operandCount] = tag;
+        this.operandValues[this.operandCount] = value;
+        this.operandCount++;
+    }
+
+    private reserveInsns(count: number) {
+        let required = count * INS_FIELDS;
+        if (required <= this.insns.length) {
+            return;
+        }
+        let capacity = this.insns.length;
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        this.insns = new Int32Array(capacity);
+    }
+
+    private reserveOperands(count: number) {
+        let required = this.operandCount + count;
+        if (required <= this.operandTags.length) {
+            return;
+        }
+        let capacity = this.operandTags.length;
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        let operandTags = new Uint8Array(capacity);
+        operandTags.set(this.operandTags.subarray(0, this.operandCount));
+        let operandValues = new Float64Array(capacity);
+        operandValues.set(this.operandValues.subarray(0, this.operandCount));
+        this.operandTags = operandTags;
+        this.operandValues = operandValues;
+    }
+
+    // the json array of the labels defined in the function, in order
+    serializeLabels(): string {
+        let text = "[";
+        let first = true;
+        for (let i = 0; i < this.insCount; i++) {
+            let base = i * INS_FIELDS;
+            if (this.insns[base + OP] != OP_LABEL) {
+                continue;
+            }
+            text += (first ? "\"" : ",\"") + LABEL_PREFIX + this.insns[base + OPERAND_BEGIN] + "\"";
+            first = false;
+        }
+        return text + "]";
+    }
+
+    // the json array of the instructions, as ts2abc parses them. Bounds are debug only
+    serializeInsns(debugMode: boolean): string {
+        let text = "[";
+        for (let i = 0; i < this.insCount; i++) {
+            let base = i * INS_FIELDS;
+            let op = this.insns[base + OP];
+            text += i == 0 ? "{\"op\":" : ",{\"op\":";
+            if (op == OP_LABEL) {
+                text += "\"\",\"label\":\"" + LABEL_PREFIX + this.insns[base + OPERAND_BEGIN] + "\"";
+            } else {
+                text += PackedInsns.opNames[op];
+                text += this.serializeOperands(OperandTag.REG, "regs", base);
+                text += this.serializeOperands(OperandTag.ID, "ids", base);
+                text += this.serializeOperands(OperandTag.IMM, "imms", base);
+            }
+
+            text += ",\"debug_pos_info\":{";
+            if (debugMode) {
+                text += "\"boundLeft\":" + this.insns[base + BOUND_LEFT] +
+                        ",\"boundRight\":" + this.insns[base + BOUND_RIGHT] + ",";
+            }
+            text += "\"lineNum\":" + this.insns[base + LINE] + ",\"columnNum\":" + this.insns[base + COLUMN] + "}}";
+        }
+        return text + "]";
+    }
+
+    // labels operands are jump targets and go with the ids
+    private serializeOperands(tag: OperandTag, name: string, base: number): string {
+        let text = "";
+        let end = this.insns[base + OPERAND_END];
+        for (let i = this.insns[base + OPERAND_BEGIN]; i < end; i++) {
+            let operandTag = this.operandTags[i];
+            if (operandTag != tag && !(tag == OperandTag.ID && operandTag == OperandTag.LABEL)) {
+                continue;
+            }
+
+            text += text == "" ? ",\"" + name + "\":[" : ",";
+            let value = this.operandValues[i];
+            if (operandTag == OperandTag.ID) {
+                text += JSON.stringify(this.ids[value]);
+            } else if (operandTag == OperandTag.LABEL) {
+                text += "\"" + LABEL_PREFIX + value + "\"";
+            } else {
+                text += serializeNumber(value);
+            }
+        }
+        return text == "" ? "" : text + "]";
+    }
+}
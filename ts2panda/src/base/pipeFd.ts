@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Synchronous writes to the pipe of a child process. Node only offers asynchronous writes to a
+ * pipe, which never complete while the synchronous compilation runs.
+ */
+
+import * as fs from "fs";
+
+const STALL_SLEEP_MS = 1;
+
+const sleepCell = new Int32Array(new (<any>global).SharedArrayBuffer(4));
+
+function nowNs(): number {
+    let time = process.hrtime();
+    return time[0] * 1e9 + time[1];
+}
+
+/**
+ * The fd under a pipe stream of node, or -1. It is read from the stream's _handle, which is
+ * private to node: it is absent for pipes on windows and possibly in other versions of node.
+ */
+export function getPipeFd(stream: any): number {
+    let handle = stream ? stream._handle : undefined;
+    return (handle && typeof handle.fd == "number" && handle.fd >= 0) ? handle.fd : -1;
+}
+
+/**
+ * Writes all of 'buffer' to 'fd' and returns the time in ns it waited for the reader.
+ * Node opens pipes non-blocking, so a full pipe fails the write with EAGAIN. There is no way to
+ * wait for the fd to become writable here: it sleeps for STALL_SLEEP_MS and retries.
+ */
+export function writeToPipeFd(fd: number, buffer: Buffer): number {
+    let stallTime = 0;
+    let offset = 0;
+    while (offset < buffer.length) {
+        try {
+            offset += fs.writeSync(fd, buffer, offset, buffer.length - offset);
+        } catch (err) {
+            if (err.code != "EAGAIN") {
+                throw err;
+            }
+            let start = nowNs();
+            (<any>global).Atomics.wait(sleepCell, 0, 0, STALL_SLEEP_MS);
+            stallTime += nowNs() - start;
+        }
+    }
+    return stallTime;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
+import { LOGD } from "../log";
+import { getPipeFd, writeToPipeFd } from "./pipeFd";
+
+const CHUNK_SIZE = 256 * 1024;
+// what the stream may hold while it reports it is full, see PipeWriter.sendToStream
+const MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+/**
+ * Writes the piece stream to ts2abc in large chunks. The compilation is synchronous, so the
+ * event loop never runs to deliver 'drain': the chunks are written to the pipe fd directly
+ * instead, and a full pipe blocks the frontend until ts2abc has read. At most one chunk is
+ * in flight, so the frontend's memory does not grow with the size of the program.
+ * Without the fd, as for pipes on windows, the chunks go through stream.write, which holds them
+ * up to a limit. Beyond it they are spilled to a temporary file, which is piped to ts2abc once the
+ * compilation has ended and the event loop runs.
+ */
+export class PipeWriter {
+    private stream: any;
+    private fd: number;
+    private chunk: Buffer = Buffer.allocUnsafe(CHUNK_SIZE);
+    private used: number = 0;
+    private bytesWritten: number = 0;
+    private writeCount: number = 0;
+    private stallTime: number = 0; // ns
+    private pending: number = 0;
+    private maxPending: number;
+    private spillDir: string = "";
+    private spillFd: number = -1;
+    private spilledBytes: number = 0;
+
+    constructor(stream: any, maxPending: number = MAX_PENDING_BYTES) {
+        this.stream = stream;
+        this.maxPending = maxPending;
+        this.fd = getPipeFd(stream);
+    }
+
+    write(data: string) {
+        let length = Buffer.byteLength(data);
+        if (this.used + length > CHUNK_SIZE) {
+            this.flush();
+        }
+
+        if (length > CHUNK_SIZE) {
+            this.send(Buffer.from(data));
+            return;
+        }
+
+        this.used += this.chunk.write(data, this.used);
+    }
+
+    flush() {
+        if (this.used > 0) {
+            this.send(this.chunk.slice(0, this.used));
+            this.used = 0;
+        }
+    }
+
+    end() {
+        this.flush();
+        if (this.spillFd >= 0) {
+            this.endWithSpill();
+        } else {
+            this.stream.end();
+        }
+        LOGD("ts2abc pipe: " + this.bytesWritten + " bytes in " + this.writeCount + " writes, stalled " +
+            (this.stallTime / 1e6).toFixed(1) + " ms, spilled " + this.spilledBytes + " bytes");
+    }
+
+    getBytesWritten(): number {
+        return this.bytesWritten;
+    }
+
+    getWriteCount(): number {
+        return this.writeCount;
+    }
+
+    // time spent waiting for ts2abc to make room in the pipe, in ms
+    getStallTime(): number {
+        return this.stallTime / 1e6;
+    }
+
+    // bytes which went through the temporary file, because the stream was full
+    getSpilledBytes(): number {
+        return this.spilledBytes;
+    }
+
+    private send(buffer: Buffer) {
+        this.writeCount++;
+        this.bytesWritten += buffer.length;
+        if (this.fd < 0) {
+            this.sendToStream(buffer);
+            return;
+        }
+
+        this.stallTime += writeToPipeFd(this.fd, buffer);
+    }
+
+    // 'drain' is never delivered while the compilation runs, so a full stream can not be waited for.
+    // Its buffer is allowed to grow to maxPending, the rest goes to the spill file so that the order
+    // is kept and the frontend does not hold the whole program in memory
+    private sendToStream(buffer: Buffer) {
+        if (this.spillFd >= 0) {
+            fs.writeSync(this.spillFd, buffer);
+            this.spilledBytes += buffer.length;
+            return;
+        }
+
+        // the stream keeps the buffer, the chunk is reused
+        if (this.stream.write(Buffer.from(buffer))) {
+            this.pending = 0;
+            return;
+        }
+
+        this.pending += buffer.length;
+        if (this.pending > this.maxPending) {
+            // mkdtemp creates the directory with mode 0700, nobody else can swap the file
+            this.spillDir = fs.mkdtempSync(path.join(os.tmpdir(), "ts2abc-"));
+            this.spillFd = fs.openSync(path.join(this.spillDir, "pieces"), "wx", 0o600);
+            LOGD("ts2abc pipe: the stream is full, spill to " + this.spillDir);
+        }
+    }
+
+    // the stream gets the spill file after what it holds, and is ended by the pipe
+    private endWithSpill() {
+        fs.closeSync(this.spillFd);
+        this.spillFd = -1;
+        let spillDir = this.spillDir;
+        let spillFile = path.join(spillDir, "pieces");
+        let input = fs.createReadStream(spillFile);
+        input.on('close', () => {
+            fs.unlinkSync(spillFile);
+            fs.rmdirSync(spillDir);
+        });
+        // a stream closed early, as by ts2abc failing, does not read the rest
+        this.stream.on('close', () => input.destroy());
+        input.pipe(this.stream);
+    }
+}
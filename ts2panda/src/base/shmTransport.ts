@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import * as fs from "fs";
+import * as path from "path";
+import { LOGD } from "../log";
+
+const SHM_DIR = "/dev/shm";
+const CHUNK_SIZE = 4 * 1024 * 1024;
+
+/**
+ * Passes the compiled program to ts2abc through a file on the shared memory filesystem.
+ * Pieces are coalesced into large chunks, and closing the fd 3 pipe tells ts2abc
+ * that the file is complete, so no data goes through the pipe itself.
+ */
+export class ShmTransport {
+    readonly fileName: string;
+    // private to this process, so nobody else can plant or swap the file
+    private dir: string;
+    private fd: number;
+    private chunk: Buffer = Buffer.allocUnsafe(CHUNK_SIZE);
+    private used: number = 0;
+
+    private constructor(dir: string, fileName: string, fd: number) {
+        this.dir = dir;
+        this.fileName = fileName;
+        this.fd = fd;
+    }
+
+    // returns undefined when shared memory is not available, the caller falls back to the pipe
+    static create(): ShmTransport | undefined {
+        if (!fs.existsSync(SHM_DIR)) {
+            return undefined;
+        }
+
+        let dir: string | undefined;
+        try {
+            // mkdtemp picks a random name and creates the directory with mode 0700
+            dir = fs.mkdtempSync(path.join(SHM_DIR, "ts2abc-"));
+            let fileName = path.join(dir, "pieces");
+            let fd = fs.openSync(fileName, "wx", 0o600);
+            return new ShmTransport(dir, fileName, fd);
+        } catch (err) {
+            LOGD("fail to create shared memory file, fall back to pipe: ", err);
+            if (dir) {
+                fs.rmdirSync(dir);
+            }
+            return undefined;
+        }
+    }
+
+    write(data: string) {
+        let length = Buffer.byteLength(data);
+        if (this.used + length > CHUNK_SIZE) {
+            this.flush();
+        }
+
+        if (length > CHUNK_SIZE) {
+            fs.writeSync(this.fd, data);
+            return;
+        }
+
+        this.used += this.chunk.write(data, this.used);
+    }
+
+    flush() {
+        if (this.used > 0) {
+            fs.writeSync(this.fd, this.chunk, 0, this.used);
+            this.used = 0;
+        }
+    }
+
+    close() {
+        this.flush();
+        fs.closeSync(this.fd);
+    }
+
+    // ts2abc unlinks the file once it has opened it, the file is only left when it failed early
+    remove() {
+        if (fs.existsSync(this.fileName)) {
+            fs.unlinkSync(this.fileName);
+        }
+        if (fs.existsSync(this.dir)) {
+            fs.rmdirSync(this.dir);
+        }
+    }
+}
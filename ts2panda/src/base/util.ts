@@ -28,6 +28,9 @@ import * as jshelpers from "../jshelpers";
 import { LOGD } from "../log";
 import { ModuleScope, Scope } from "../scope";
 import { isFunctionLikeDeclaration } from "../syntaxCheckHelper";
+import { CmdOptions } from "../cmdOptions";
+import { PipeWriter } from "./pipeWriter";
+import { ShmTransport } from "./shmTransport";
 
 export function containSpreadElement(args?: ts.NodeArray<ts.Expression>): boolean {
     if (!args) {
@@ -194,20 +197,46 @@ export function escapeUnicode(data: string) {
 export function initiateTs2abc(args: Array<string>) {
     let js2abc = path.join(path.resolve(__dirname, '../../bin'), "js2abc");
     args.unshift("--compile-by-pipe");
+    let shmTransport = CmdOptions.isShmTransport() ? ShmTransport.create() : undefined;
+    if (shmTransport) {
+        args.unshift("--shm-file", shmTransport.fileName);
+    }
     var spawn = require('child_process').spawn;
     let child = spawn(js2abc, [...args], {
         stdio: ['pipe', 'inherit', 'inherit', 'pipe']
     });
 
+    if (shmTransport) {
+        child.shmTransport = shmTransport;
+        child.on('exit', () => shmTransport!.remove());
+    } else {
+        child.pipeWriter = new PipeWriter(child.stdio[3]);
+    }
+
     return child;
 }
 
+export function writeToTs2abc(ts2abc: any, data: string) {
+    if (ts2abc.shmTransport) {
+        ts2abc.shmTransport.write(data);
+        return;
+    }
+
+    ts2abc.pipeWriter.write(data);
+}
+
 export function terminateWritePipe(ts2abc: any) {
     if (!ts2abc) {
         LOGD("ts2abc is not a valid object");
     }
 
-    ts2abc.stdio[3].end();
+    if (ts2abc.shmTransport) {
+        ts2abc.shmTransport.close();
+        ts2abc.stdio[3].end();
+        return;
+    }
+
+    ts2abc.pipeWriter.end();
 }
 
 export function listenChildExit(child: any) {
@@ -27,7 +27,7 @@ const ts2pandaOptions = [
     { name: 'debug-log', alias: 'l', type: Boolean, defaultValue: false, description: "show info debug log."},
     { name: 'dump-assembly', alias: 'a', type: Boolean, defaultValue: false, description: "dump assembly to file."},
     { name: 'debug', alias: 'd', type: Boolean, defaultValue: false, description: "compile with debug info."},
-    { name: 'show-statistics', alias: 's', type: String, lazyMultiple: true, defaultValue: "", description: "show compile statistics(ast, histogram, hoisting, all)."},
+    { name: 'show-statistics', alias: 's', type: String, lazyMultiple: true, defaultValue: "", description: "show compile statistics(ast, histogram, hoisting, timing, memory, all)."},
     { name: 'output', alias: 'o', type: String, defaultValue: "", description: "set output file."},
     { name: 'timeout', alias: 't', type: Number, defaultValue: 0, description: "js to abc timeout threshold(unit: seconds)."},
     { name: 'opt-log-level', type: String, defaultValue: "error", description: "specifie optimizer log level. Possible values: ['debug', 'info', 'error', 'fatal']"},
@@ -36,7 +36,14 @@ const ts2pandaOptions = [
                                                                     2: other bytecode optimizations, unimplemented yet"},
     { name: 'help', alias: 'h', type: Boolean, description: "Show usage guide."},
     { name: 'bc-version', alias: 'v', type: Boolean, defaultValue: false, description: "Print ark bytecode version"},
-    { name: 'bc-min-version', type: Boolean, defaultValue: false, description: "Print ark bytecode minimum supported version"}
+    { name: 'bc-min-version', type: Boolean, defaultValue: false, description: "Print ark bytecode minimum supported version"},
+    { name: 'shm-transport', type: Boolean, defaultValue: false, description: "pass data to ts2abc through shared memory instead of the pipe, if available."},
+    { name: 'incremental', type: Boolean, defaultValue: false, description: "only pass changed functions to ts2abc, reusing the rest from the last build."},
+    { name: 'jobs', alias: 'j', type: Number, defaultValue: 1, description: "compile the source files in this many worker threads, each with its own ts2abc."},
+    { name: 'transpile-only', type: Boolean, defaultValue: false, description: "compile each given file on its own, without type checking. Imported files are not compiled."},
+    { name: 'build-info', type: Boolean, defaultValue: false, description: "skip the source files whose content, imports and options did not change since the last build."},
+    { name: 'link', type: String, defaultValue: "", description: "link the outputs of all compiled files into this single file, with the input file as its entry."},
+    { name: 'split-debug-info', type: String, defaultValue: "", description: "compile a release build and write the debug info a debug build would carry (local variables, source code and columns) into this directory, in a file named after the checksum of the output."}
 ]
 
 export class CmdOptions {
@@ -64,6 +71,18 @@ export class CmdOptions {
         return this.options["debug"];
     }
 
+    // --split-debug-info collects the debug info of a debug build for the sidecar, but generates release code
+    static isDebugInfoCollected(): boolean {
+        return this.isDebugMode() || this.getSplitDebugInfo() != "";
+    }
+
+    static getSplitDebugInfo(): string {
+        if (!this.options) {
+            return "";
+        }
+        return this.options["split-debug-info"];
+    }
+
     static isModules(): boolean {
         if (!this.options) {
             return false;
@@ -78,6 +97,60 @@ export class CmdOptions {
         return this.options["variant-bytecode"];
     }
 
+    static isShmTransport(): boolean {
+        if (!this.options) {
+            return false;
+        }
+        return this.options["shm-transport"];
+    }
+
+    static isIncremental(): boolean {
+        if (!this.options) {
+            return false;
+        }
+        return this.options["incremental"];
+    }
+
+    static isTranspileOnly(): boolean {
+        if (!this.options) {
+            return false;
+        }
+        return this.options["transpile-only"];
+    }
+
+    static isBuildInfo(): boolean {
+        if (!this.options) {
+            return false;
+        }
+        return this.options["build-info"];
+    }
+
+    // the options which change the output, as a string that can be hashed
+    static getOutputOptions(): string {
+        let outputOptions: any = {};
+        let ignored = ["_unknown", "jobs", "show-statistics", "debug-log", "timeout"];
+        Object.keys(this.options).sort().forEach((name) => {
+            if (ignored.indexOf(name) == -1) {
+                outputOptions[name] = this.options[name];
+            }
+        });
+        return JSON.stringify(outputOptions);
+    }
+
+    static getJobs(): number {
+        if (!this.options) {
+            return 1;
+        }
+        return this.options["jobs"];
+    }
+
+    static getLinkOutput(): string {
+        if (!this.options) {
+            return "";
+        }
+        return this.options["link"];
+    }
+
     static getOptLevel(): number {
         return this.options["opt-level"];
     }
@@ -107,6 +180,20 @@ export class CmdOptions {
         return this.options["show-statistics"].includes("all") || this.options["show-statistics"].includes("hoisting");
     }
 
+    static showTimingStatistics(): boolean {
+        if (!this.options) {
+            return false;
+        }
+        return this.options["show-statistics"].includes("all") || this.options["show-statistics"].includes("timing");
+    }
+
+    static showMemoryStatistics(): boolean {
+        if (!this.options) {
+            return false;
+        }
+        return this.options["show-statistics"].includes("all") || this.options["show-statistics"].includes("memory");
+    }
+
     static getInputFileName(): string {
         let path = this.parsedResult.fileNames[0];
         let inputFile = path.substring(0, path.lastIndexOf('.'));
@@ -13,10 +13,11 @@
  * limitations under the License.
  */
 
-import { writeFileSync } from "fs";
+import { mkdirSync, writeFileSync } from "fs";
 import * as ts from "typescript";
 import { addVariableToScope } from "./addVariable2Scope";
 import { AssemblyDumper } from "./assemblyDumper";
+import { IncrementalCache } from "./base/incrementalCache";
 import { initiateTs2abc, listenChildExit, listenErrorEvent, terminateWritePipe } from "./base/util";
 import { CmdOptions } from "./cmdOptions";
 import {
@@ -42,6 +43,7 @@ import {
 } from "./scope";
 import { getClassNameForConstructor } from "./statement/classStatement";
 import { checkDuplicateDeclaration, checkExportEntries } from "./syntaxChecker";
+import { TimingStatistics } from "./timingStatistics";
 import { Ts2Panda } from "./ts2panda";
 
 export class PendingCompilationUnit {
@@ -66,6 +68,7 @@ export class CompilerDriver {
     private statistics: CompilerStatistics;
     private needDumpHeader: boolean = true;
     private ts2abcProcess: any = undefined;
+    private moduleRequests: string[] = [];
 
     constructor(fileName: string) {
         this.fileName = fileName;
@@ -81,7 +84,27 @@ export class CompilerDriver {
     }
 
     initiateTs2abcChildProcess() {
-        this.ts2abcProcess = initiateTs2abc([this.fileName]);
+        let args = [this.fileName];
+        let incrementalCache: IncrementalCache | undefined;
+        if (CmdOptions.isIncremental()) {
+            incrementalCache = new IncrementalCache(this.fileName);
+            args.unshift("--incremental-cache", incrementalCache.cacheFile);
+        } else if (CmdOptions.getLinkOutput() != "") {
+            // without a base ts2abc just keeps the piece stream, which is what the linker reads
+            args.unshift("--incremental-cache", IncrementalCache.getCacheFile(this.fileName));
+        }
+        if (TimingStatistics.isEnabled()) {
+            args.unshift("--timing-file", TimingStatistics.getTs2abcTimingFile(this.fileName));
+        }
+        if (CmdOptions.showMemoryStatistics()) {
+            args.unshift("--mem-stat");
+        }
+        if (CmdOptions.getSplitDebugInfo() != "") {
+            mkdirSync(CmdOptions.getSplitDebugInfo(), { recursive: true });
+            args.unshift("--split-debug-info", CmdOptions.getSplitDebugInfo());
+        }
+        this.ts2abcProcess = initiateTs2abc(args);
+        this.ts2abcProcess.incrementalCache = incrementalCache;
     }
 
     getTs2abcProcess(): any {
@@ -91,6 +114,11 @@ export class CompilerDriver {
         return this.ts2abcProcess;
     }
 
+    // the modules this file imports or re-exports from
+    getModuleRequests(): string[] {
+        return this.moduleRequests;
+    }
+
     getStatistics() {
         return this.statistics;
     }
@@ -155,7 +183,12 @@ export class CompilerDriver {
             });
         }
 
-        let recorder = this.compilePrologue(node);
+        let recorder = TimingStatistics.measure("record", undefined, () => this.compilePrologue(node));
+        recorder.getImportStmts().concat(recorder.getExportStmts()).forEach((moduleStmt) => {
+            if (moduleStmt.getModuleRequest() != "") {
+                this.moduleRequests.push(moduleStmt.getModuleRequest());
+            }
+        });
 
         // initiate ts2abc
         if (!CmdOptions.isAssemblyMode()) {
@@ -172,8 +205,11 @@ export class CompilerDriver {
                     this.compileImpl(unit.decl, unit.scope, unit.internalName, recorder);
                 }
 
-                Ts2Panda.dumpStringsArray(ts2abcProc);
-                Ts2Panda.dumpConstantPool(ts2abcProc);
+                TimingStatistics.measure("serialize", undefined, () => {
+                    Ts2Panda.dumpRemovedFunctions(ts2abcProc);
+                    Ts2Panda.dumpStringsArray(ts2abcProc);
+                    Ts2Panda.dumpConstantPool(ts2abcProc);
+                });
 
                 terminateWritePipe(ts2abcProc);
                 if (CmdOptions.isEnableDebugLog()) {
@@ -210,22 +246,30 @@ export class CompilerDriver {
             setExportBinding(recorder.getExportStmts(), scope, pandaGen);
         }
 
+        let timingName = TimingStatistics.isEnabled() ? TimingStatistics.functionKey(this.fileName, internalName) : undefined;
+
         // because of para vreg, don't change hosting's position
-        hoisting(node, pandaGen, recorder, compiler);
-        compiler.compile();
+        TimingStatistics.measure("hoisting", timingName, () => hoisting(node, pandaGen, recorder, compiler));
+        TimingStatistics.measure("compile", timingName, () => compiler.compile());
 
-        this.passes.forEach((pass) => pass.run(pandaGen));
+        this.passes.forEach((pass) => {
+            TimingStatistics.measure(pass.constructor.name, timingName, () => pass.run(pandaGen));
+        });
 
         // for debug info
-        DebugInfo.addDebugIns(scope, pandaGen, false);
-        DebugInfo.setDebugInfo(pandaGen);
-        DebugInfo.setSourceFileDebugInfo(pandaGen, node);
-
-        if (CmdOptions.isAssemblyMode()) {
-            this.writeBinaryFile(pandaGen);
-        } else {
-            Ts2Panda.dumpPandaGen(pandaGen, this.getTs2abcProcess());
-        }
+        TimingStatistics.measure("debugInfo", timingName, () => {
+            DebugInfo.addDebugIns(scope, pandaGen, false);
+            DebugInfo.setDebugInfo(pandaGen);
+            DebugInfo.setSourceFileDebugInfo(pandaGen, node);
+        });
+
+        TimingStatistics.measure("serialize", timingName, () => {
+            if (CmdOptions.isAssemblyMode()) {
+                this.writeBinaryFile(pandaGen);
+            } else {
+                Ts2Panda.dumpPandaGen(pandaGen, this.getTs2abcProcess());
+            }
+        });
 
         if (CmdOptions.showHistogramStatistics()) {
             this.statistics.getInsHistogramStatistics(pandaGen);
@@ -334,7 +334,7 @@ export class DebugInfo {
     public static setDebugInfo(pandaGen: PandaGen) {
         // set position debug info
         DebugInfo.setPosDebugInfo(pandaGen);
-        if (CmdOptions.isDebugMode()) {
+        if (CmdOptions.isDebugInfoCollected()) {
             // set variable debug info
             DebugInfo.setVariablesDebugInfo(pandaGen);
 
@@ -351,7 +351,7 @@ export class DebugInfo {
         let sourceFile = jshelpers.getSourceFileOfNode(node);
         pandaGen.setSourceFileDebugInfo(sourceFile.fileName);
 
-        if (CmdOptions.isDebugMode()) {
+        if (CmdOptions.isDebugInfoCollected()) {
             if (ts.isSourceFile(node)) {
                 pandaGen.setSourceCodeDebugInfo(node.text);
             }
@@ -368,7 +368,8 @@ export class DebugInfo {
     }
 
     public static addDebugIns(scope: Scope, pandaGen: PandaGen, isStart: boolean) {
-        if (!CmdOptions.isDebugMode()) {
+        // the placeholders only mark scopes for the variable info, they are removed before serialization
+        if (!CmdOptions.isDebugInfoCollected()) {
             return;
         }
         let insns = pandaGen.getInsns();
@@ -14,19 +14,84 @@
  */
 
 import * as ts from "typescript";
+import { BuildManifest } from "./base/buildManifest";
 import { CmdOptions } from "./cmdOptions";
-import { CompilerDriver } from "./compilerDriver";
 import * as diag from "./diagnostic";
-import { LOGD, LOGE } from "./log";
-import { Pass } from "./pass";
-import { CacheExpander } from "./pass/cacheExpander";
-import { ICPass } from "./pass/ICPass";
-import { RegAlloc } from "./regAllocator";
-import { setGlobalStrict } from "./strictMode";
-import jshelpers = require("./jshelpers");
+import {
+    compileFileInIsolation,
+    compileInParallel,
+    compileSourceFile,
+    getCompiledSourceFiles,
+    printCompileError
+} from "./parallelCompiler";
+import { LOGD } from "./log";
+import { isLinking, linkOnExit } from "./moduleLinker";
+import { TimingStatistics } from "./timingStatistics";
+
+// each file on its own, no program and no semantic diagnostics
+function transpileOnly(fileNames: string[], options: ts.CompilerOptions, args: string[]) {
+    if (isLinking()) {
+        linkOnExit(fileNames);
+    }
+
+    let manifest = BuildManifest.getCurrent();
+    if (manifest) {
+        fileNames = manifest.filterDirty(fileNames);
+    }
+
+    if (CmdOptions.getJobs() > 1 && fileNames.length > 1) {
+        compileInParallel(fileNames.slice().sort(), options, args, CmdOptions.getJobs());
+        return;
+    }
+
+    fileNames.forEach(fileName => {
+        compileFileInIsolation(fileName, options);
+    });
+}
+
+function main(fileNames: string[], options: ts.CompilerOptions, args: string[]) {
+    let manifest: BuildManifest | undefined;
+    if (CmdOptions.isBuildInfo() && !CmdOptions.isAssemblyMode()) {
+        manifest = new BuildManifest(CmdOptions.getOutputBinName() + ".buildinfo",
+                                     CmdOptions.getOutputOptions() + JSON.stringify(options));
+        BuildManifest.setCurrent(manifest);
+        // nothing changed, not even the program needs to be built
+        if (manifest.isAllUpToDate(fileNames)) {
+            LOGD("all outputs are up to date");
+            manifest.keepAll();
+            if (isLinking()) {
+                linkOnExit(manifest.getFileNames());
+            }
+            return;
+        }
+    }
+
+    if (CmdOptions.isTranspileOnly()) {
+        transpileOnly(fileNames, options, args);
+        return;
+    }
+
+    let program = TimingStatistics.measure("createProgram", undefined, () => ts.createProgram(fileNames, options));
+    let compiledFiles = getCompiledSourceFiles(program);
+    if (isLinking()) {
+        linkOnExit(compiledFiles);
+    }
+    if (CmdOptions.getJobs() > 1 && compiledFiles.length > 1) {
+        // type check once here, the workers only compile
+        let diagnostics = TimingStatistics.measure("getPreEmitDiagnostics", undefined, () => ts.getPreEmitDiagnostics(program));
+        diagnostics.forEach(diagnostic => {
+            diag.printDiagnostic(diagnostic);
+        });
+        if (options.noEmitOnError && diagnostics.some(diagnostic => diagnostic.category == ts.DiagnosticCategory.Error)) {
+            return;
+        }
+        if (manifest) {
+            compiledFiles = manifest.filterDirty(compiledFiles);
+        }
+        compileInParallel(compiledFiles, options, args, CmdOptions.getJobs());
+        return;
+    }
 
-function main(fileNames: string[], options: ts.CompilerOptions) {
-    let program = ts.createProgram(fileNames, options);
     let emitResult = program.emit(
         undefined,
         undefined,
@@ -36,24 +101,10 @@ function main(fileNames: string[], options: ts.CompilerOptions) {
             before: [
                 (ctx: ts.TransformationContext) => {
                     return (node: ts.SourceFile) => {
-                        let outputBinName = CmdOptions.getOutputBinName();
-                        let fileName = node.fileName.substring(0, node.fileName.lastIndexOf('.'));
-                        if (fileName != CmdOptions.getInputFileName()) {
-                            outputBinName = fileName + ".abc";
+                        if (manifest && manifest.filterDirty([node.fileName]).length == 0) {
+                            return node;
                         }
-                        let compilerDriver = new CompilerDriver(outputBinName);
-                        setGlobalStrict(jshelpers.isEffectiveStrictModeSourceFile(node, options));
-                        if (CmdOptions.isVariantBytecode()) {
-                            LOGD("variant bytecode dump");
-                            let passes: Pass[] = [
-                                new CacheExpander(),
-                                new ICPass(),
-                                new RegAlloc()
-                            ];
-                            compilerDriver.setCustomPasses(passes);
-                        }
-                        compilerDriver.compile(node);
-                        compilerDriver.showStatistics();
+                        compileSourceFile(node, options);
                         return node;
                     }
                 }
@@ -61,8 +112,7 @@ function main(fileNames: string[], options: ts.CompilerOptions) {
         }
     );
 
-    let allDiagnostics = ts
-        .getPreEmitDiagnostics(program)
+    let allDiagnostics = TimingStatistics.measure("getPreEmitDiagnostics", undefined, () => ts.getPreEmitDiagnostics(program))
         .concat(emitResult.diagnostics);
 
     allDiagnostics.forEach(diagnostic => {
@@ -98,19 +148,9 @@ function run(args: string[], options?: ts.CompilerOptions): void {
         }
     }
     try {
-        main(parsed.fileNames, parsed.options);
+        main(parsed.fileNames, parsed.options, args);
     } catch (err) {
-        if (err instanceof diag.DiagnosticError) {
-            let diagnostic = diag.getDiagnostic(err.code);
-            if (diagnostic != undefined) {
-                let diagnosticLog = diag.createDiagnostic(err.file, err.irnode, diagnostic, ...err.args);
-                diag.printDiagnostic(diagnosticLog);
-            }
-        } else if (err instanceof SyntaxError) {
-            LOGE(err.name, err.message);
-        } else {
-            throw err;
-        }
+        printCompileError(err);
     }
 }
 
@@ -20,6 +20,7 @@ export function isJsFile(file: ts.SourceFile): boolean;
 export function createEmptyNodeArray<T extends ts.Node>(): ts.NodeArray<T>;
 export function getFlowNode(stmt: ts.Statement): ts.Node;
 export function bindSourceFile(sourceFile: ts.SourceFile, options: ts.CompilerOptions);
+export function getSyntacticDiagnostics(sourceFile: ts.SourceFile): ts.Diagnostic[];
 export function createDiagnosticForNode(node: ts.Node, message: ts.DiagnosticMessage, ...args: (string | number | undefined)[]): ts.DiagnosticWithLocation;
 export function createCompilerDiagnostic(message: ts.DiagnosticMessage, ...args: (string | number | undefined)[]): ts.Diagnostic;
 export function createCompilerDiagnostic(message: ts.DiagnosticMessage, ...args: (string | number | undefined)[]): ts.Diagnostic;
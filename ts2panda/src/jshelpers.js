@@ -43,6 +43,10 @@ function bindSourceFile(sourceFile, options) {
   ts.bindSourceFile(sourceFile, options);
 }
 
+function getSyntacticDiagnostics(sourceFile) {
+  return sourceFile.parseDiagnostics.concat(sourceFile.bindDiagnostics || []);
+}
+
 function createDiagnosticForNode(node, message, ...args) {
   return ts.createDiagnosticForNode(node, message, ...args);
 }
@@ -259,6 +263,7 @@ module.exports = {
   createEmptyNodeArray: createEmptyNodeArray,
   getFlowNode: getFlowNode,
   bindSourceFile: bindSourceFile,
+  getSyntacticDiagnostics: getSyntacticDiagnostics,
   createDiagnosticForNode: createDiagnosticForNode,
   createCompilerDiagnostic: createCompilerDiagnostic,
   createFileDiagnostic: createFileDiagnostic,
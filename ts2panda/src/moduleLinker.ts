@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import * as fs from "fs";
+import * as path from "path";
+import { IncrementalCache } from "./base/incrementalCache";
+import { CmdOptions } from "./cmdOptions";
+import { LOGD, LOGE } from "./log";
+import { getOutputBinNameOfFile } from "./parallelCompiler";
+
+export function isLinking(): boolean {
+    return CmdOptions.getLinkOutput() != "" && !CmdOptions.isAssemblyMode();
+}
+
+/**
+ * Links the outputs of 'fileNames' into the single file given by --link, once every ts2abc
+ * has exited. ts2abc reads back the piece streams it kept next to each output, so the files
+ * need not be compiled together. The input file is the entry of the linked file, the others
+ * are named after their path relative to it.
+ */
+export function linkOnExit(fileNames: string[]) {
+    let entryOutput = path.resolve(CmdOptions.getOutputBinName());
+    let entryDir = path.dirname(path.resolve(CmdOptions.getInputFileName()));
+    let modules: [string, string][] = [];
+    fileNames.slice().sort().forEach((fileName) => {
+        let output = path.resolve(getOutputBinNameOfFile(fileName));
+        let moduleName = path.relative(entryDir, output.substring(0, output.lastIndexOf('.'))).split(path.sep).join('/');
+        let module: [string, string] = [moduleName, IncrementalCache.getCacheFile(output)];
+        if (output == entryOutput) {
+            modules.unshift(module);
+        } else {
+            modules.push(module);
+        }
+    });
+
+    process.on('exit', () => {
+        if (process.exitCode) {
+            return;
+        }
+        let missing = modules.filter((module) => !fs.existsSync(module[1]));
+        if (missing.length > 0) {
+            LOGE("cannot link, the compilation of " + missing[0][0] + " failed");
+            process.exitCode = 1;
+            return;
+        }
+
+        let linkList = CmdOptions.getLinkOutput() + ".link";
+        fs.writeFileSync(linkList, modules.map((module) => module[0] + "\t" + module[1]).join("\n") + "\n");
+        let js2abc = path.join(path.resolve(__dirname, '../bin'), "js2abc");
+        let args = ["--link", linkList, CmdOptions.getLinkOutput()];
+        if (CmdOptions.getSplitDebugInfo() != "") {
+            args.unshift("--split-debug-info", CmdOptions.getSplitDebugInfo());
+        }
+        let result = require('child_process').spawnSync(js2abc, args, {
+            stdio: ['ignore', 'inherit', 'inherit']
+        });
+        if (result.status !== 0) {
+            LOGE("fail to link " + CmdOptions.getLinkOutput());
+            process.exitCode = 1;
+            return;
+        }
+        LOGD("linked " + modules.length + " files into " + CmdOptions.getLinkOutput());
+    });
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import * as fs from "fs";
+import * as ts from "typescript";
+import { isMainThread, parentPort, Worker, workerData } from "worker_threads";
+import { BuildEntry, BuildManifest } from "./base/buildManifest";
+import { CmdOptions } from "./cmdOptions";
+import { CompilerDriver } from "./compilerDriver";
+import * as diag from "./diagnostic";
+import { LOGD, LOGE } from "./log";
+import { Pass } from "./pass";
+import { CacheExpander } from "./pass/cacheExpander";
+import { ICPass } from "./pass/ICPass";
+import { RegAlloc } from "./regAllocator";
+import { setGlobalStrict } from "./strictMode";
+import { checkTranspileOnly } from "./syntaxChecker";
+import { TimingRecord, TimingStatistics } from "./timingStatistics";
+import jshelpers = require("./jshelpers");
+
+export function getOutputBinNameOfFile(sourceFileName: string): string {
+    let outputBinName = CmdOptions.getOutputBinName();
+    let fileName = sourceFileName.substring(0, sourceFileName.lastIndexOf('.'));
+    if (fileName != CmdOptions.getInputFileName()) {
+        outputBinName = fileName + ".abc";
+    }
+    return outputBinName;
+}
+
+export function getOutputBinName(node: ts.SourceFile): string {
+    return getOutputBinNameOfFile(node.fileName);
+}
+
+export function compileSourceFile(node: ts.SourceFile, options: ts.CompilerOptions): CompilerDriver {
+    let compilerDriver = new CompilerDriver(getOutputBinName(node));
+    setGlobalStrict(jshelpers.isEffectiveStrictModeSourceFile(node, options));
+    if (CmdOptions.isVariantBytecode()) {
+        LOGD("variant bytecode dump");
+        let passes: Pass[] = [
+            new CacheExpander(),
+            new ICPass(),
+            new RegAlloc()
+        ];
+        compilerDriver.setCustomPasses(passes);
+    }
+    compilerDriver.compile(node);
+    compilerDriver.showStatistics();
+    if (CmdOptions.isBuildInfo() && !CmdOptions.isAssemblyMode()) {
+        trackBuildInfo(compilerDriver, node, options);
+    }
+    return compilerDriver;
+}
+
+// the file goes into the build info only once ts2abc has written its output
+function trackBuildInfo(compilerDriver: CompilerDriver, node: ts.SourceFile, options: ts.CompilerOptions) {
+    let fileName = node.fileName;
+    let entry = BuildManifest.createEntry(fileName, getOutputBinName(node), compilerDriver.getModuleRequests(), options);
+    compilerDriver.getTs2abcProcess().on('exit', (code: any) => {
+        if (code === 0 && entry) {
+            BuildManifest.addBuilt(fileName, entry);
+        }
+    });
+}
+
+export function printCompileError(err: any) {
+    if (err instanceof diag.DiagnosticError) {
+        let diagnostic = diag.getDiagnostic(err.code);
+        if (diagnostic != undefined) {
+            let diagnosticLog = diag.createDiagnostic(err.file, err.irnode, diagnostic, ...err.args);
+            diag.printDiagnostic(diagnosticLog);
+        }
+    } else if (err instanceof SyntaxError) {
+        LOGE(err.name, err.message);
+    } else {
+        throw err;
+    }
+}
+
+// the files the emit transformer would be called for
+export function getCompiledSourceFiles(program: ts.Program): string[] {
+    let fileNames: string[] = [];
+    program.getSourceFiles().forEach((sourceFile) => {
+        if (sourceFile.isDeclarationFile || program.isSourceFileFromExternalLibrary(sourceFile) ||
+            program.isSourceFileDefaultLibrary(sourceFile)) {
+            return;
+        }
+        fileNames.push(sourceFile.fileName);
+    });
+
+    // each file is compiled on its own, sorting only fixes the order of the logs
+    return fileNames.sort();
+}
+
+// what a worker reports after each file, the main thread keeps the build info and writes the reports
+interface WorkerResult {
+    built: [string, BuildEntry][];
+    timing?: TimingRecord;
+}
+
+/**
+ * Compile every file in a pool of worker threads, each of them driving its own ts2abc.
+ * Type checking has been done by the caller, workers only parse and bind their file,
+ * so the output of a file does not depend on which worker compiled it.
+ */
+export function compileInParallel(fileNames: string[], options: ts.CompilerOptions, args: string[], jobs: number) {
+    let pending = fileNames.slice();
+    let workerNum = Math.min(jobs, pending.length);
+    LOGD("compile " + pending.length + " files with " + workerNum + " workers");
+
+    for (let i = 0; i < workerNum; i++) {
+        let worker = new Worker(__filename, { workerData: { args: args, options: options } });
+        let dispatch = () => {
+            // an undefined file tells the worker to finish
+            worker.postMessage(pending.shift());
+        };
+        worker.on('message', (result: WorkerResult) => {
+            result.built.forEach((item) => BuildManifest.addBuilt(item[0], item[1]));
+            if (result.timing) {
+                TimingStatistics.addRecorded(result.timing);
+            }
+            dispatch();
+        });
+        worker.on('error', (err: any) => {
+            LOGE("compile worker failed", err);
+            process.exitCode = 1;
+        });
+        dispatch();
+    }
+}
+
+/**
+ * Parse, bind and compile one file without a program, so without the type checker.
+ * Returns undefined when the file has syntax errors, they have been printed then.
+ */
+export function compileFileInIsolation(fileName: string, options: ts.CompilerOptions): CompilerDriver | undefined {
+    let languageVersion = options.target !== undefined ? options.target : ts.ScriptTarget.ES2015;
+    let sourceFile = ts.createSourceFile(fileName, fs.readFileSync(fileName, "utf-8"), languageVersion, true);
+    jshelpers.bindSourceFile(sourceFile, options);
+
+    // without --transpile-only the program has reported these already
+    let diagnostics = jshelpers.getSyntacticDiagnostics(sourceFile);
+    if (CmdOptions.isTranspileOnly()) {
+        diagnostics.forEach(diagnostic => {
+            diag.printDiagnostic(diagnostic);
+        });
+    }
+    if (diagnostics.some(diagnostic => diagnostic.category == ts.DiagnosticCategory.Error)) {
+        return undefined;
+    }
+
+    if (CmdOptions.isTranspileOnly()) {
+        checkTranspileOnly(sourceFile);
+    }
+    return compileSourceFile(sourceFile, options);
+}
+
+function compileInWorker(fileName: string, options: ts.CompilerOptions, done: () => void) {
+    try {
+        let compilerDriver = compileFileInIsolation(fileName, options);
+
+        // take the next file only once this ts2abc is done, so there are at most 'jobs' of them
+        let ts2abc = (!compilerDriver || CmdOptions.isAssemblyMode()) ? undefined : compilerDriver.getTs2abcProcess();
+        if (ts2abc && ts2abc.exitCode === null && ts2abc.signalCode === null) {
+            ts2abc.on('exit', done);
+            return;
+        }
+    } catch (err) {
+        printCompileError(err);
+    }
+    done();
+}
+
+if (!isMainThread && workerData && workerData.args) {
+    CmdOptions.parseUserCmd(workerData.args);
+    parentPort!.on('message', (fileName: string | undefined) => {
+        if (fileName === undefined) {
+            parentPort!.close();
+            return;
+        }
+        compileInWorker(fileName, workerData.options, () => {
+            let result: WorkerResult = { built: BuildManifest.takeBuilt() };
+            if (TimingStatistics.isEnabled()) {
+                result.timing = TimingStatistics.takeRecorded();
+            }
+            parentPort!.postMessage(result);
+        });
+    });
+}
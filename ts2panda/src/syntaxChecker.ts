@@ -1424,4 +1424,16 @@ export function checkExportEntries(recorder: Recorder) {
             }
         })
     })
-}
\ No newline at end of file
+}
+
+// with --transpile-only nothing is known about other files, reject what only the type checker could compile
+export function checkTranspileOnly(file: ts.SourceFile) {
+    let visit = (node: ts.Node) => {
+        if (ts.isEnumDeclaration(node) && node.modifiers &&
+            node.modifiers.some(modifier => modifier.kind == ts.SyntaxKind.ConstKeyword)) {
+            throw new DiagnosticError(node.name, DiagnosticCode._0_needs_type_information_and_cannot_be_compiled_with_transpile_only, file, ["const enum " + node.name.text]);
+        }
+        ts.forEachChild(node, visit);
+    };
+    ts.forEachChild(file, visit);
+}
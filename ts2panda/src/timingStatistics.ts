@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import * as fs from "fs";
+import * as v8 from "v8";
+import { isMainThread, threadId } from "worker_threads";
+import { CmdOptions } from "./cmdOptions";
+import { LOGD } from "./log";
+
+const TOP_FUNCTIONS_NUM = 10;
+const NS_PER_MS = 1e6;
+const NS_PER_US = 1e3;
+
+/**
+ * One timed span, in the chrome trace event format. ts2abc writes its phases in the
+ * same format, so both processes end up on one timeline in the final report.
+ */
+export interface TraceEvent {
+    name: string;
+    cat: string;
+    ph: string;
+    ts: number;
+    dur: number;
+    pid: number;
+    tid: number;
+    args?: any;
+}
+
+export class PhaseTiming {
+    time: number = 0; // ns
+    count: number = 0;
+    heapGrowth: number = 0; // bytes
+}
+
+/**
+ * What a compile worker recorded, handed to the main thread with its built files.
+ * Only the main thread writes the report.
+ */
+export interface TimingRecord {
+    phases: [string, PhaseTiming][];
+    functions: [string, [string, number][]][];
+    events: TraceEvent[];
+    ts2abcTimingFiles: string[];
+    heapPeak: number;
+    gcCount: number;
+    gcTime: number;
+}
+
+function nowNs(): number {
+    let time = process.hrtime();
+    return time[0] * 1e9 + time[1];
+}
+
+// only the js heap: process.memoryUsage() also reads the rss from /proc, too slow for every phase of every function
+function heapUsed(): number {
+    return v8.getHeapStatistics().used_heap_size;
+}
+
+function padEnd(str: string, width: number): string {
+    while (str.length < width) {
+        str += " ";
+    }
+    return str;
+}
+
+export class TimingStatistics {
+    private static phases: Map<string, PhaseTiming> = new Map<string, PhaseTiming>();
+    private static functions: Map<string, Map<string, number>> = new Map<string, Map<string, number>>();
+    private static events: TraceEvent[] = [];
+    private static ts2abcTimingFiles: string[] = [];
+    // hrtime has no fixed origin, anchor it to the wall clock so that the ts2abc events line up
+    private static epochOffsetNs: number = Date.now() * NS_PER_MS - nowNs();
+    private static heapStart: number = 0;
+    private static heapPeak: number = 0;
+    private static gcCount: number = 0;
+    private static gcTime: number = 0; // ms
+    private static reportRegistered: boolean = false;
+
+    static isEnabled(): boolean {
+        return CmdOptions.showTimingStatistics();
+    }
+
+    // functions are told apart by their file too, every file has its own func_main_0
+    static functionKey(fileName: string, internalName: string): string {
+        return fileName + ": " + internalName;
+    }
+
+    /**
+     * Run 'func' as the phase 'phase', attributing the time to 'funcName' when given.
+     * Nested phases are counted in both, so only time disjoint phases for the summary.
+     */
+    static measure<T>(phase: string, funcName: string | undefined, func: () => T): T {
+        if (!TimingStatistics.isEnabled()) {
+            return func();
+        }
+
+        TimingStatistics.registerReport();
+        let heapBefore = heapUsed();
+        let start = nowNs();
+        try {
+            return func();
+        } finally {
+            let duration = nowNs() - start;
+            let heapAfter = heapUsed();
+            TimingStatistics.record(phase, funcName, start, duration, heapAfter - heapBefore);
+            TimingStatistics.heapPeak = Math.max(TimingStatistics.heapPeak, heapAfter);
+        }
+    }
+
+    private static record(phase: string, funcName: string | undefined, start: number, duration: number, heapGrowth: number) {
+        let phaseTiming = TimingStatistics.phases.get(phase);
+        if (!phaseTiming) {
+            phaseTiming = new PhaseTiming();
+            TimingStatistics.phases.set(phase, phaseTiming);
+        }
+        phaseTiming.time += duration;
+        phaseTiming.count++;
+        phaseTiming.heapGrowth += heapGrowth;
+
+        let args: any = { "heap_growth": heapGrowth };
+        if (funcName !== undefined) {
+            let funcTiming = TimingStatistics.functions.get(funcName);
+            if (!funcTiming) {
+                funcTiming = new Map<string, number>();
+                TimingStatistics.functions.set(funcName, funcTiming);
+            }
+            funcTiming.set(phase, (funcTiming.get(phase) || 0) + duration);
+            args["function"] = funcName;
+        }
+
+        TimingStatistics.events.push({
+            name: phase,
+            cat: "ts2panda",
+            ph: "X",
+            ts: (TimingStatistics.epochOffsetNs + start) / NS_PER_US,
+            dur: duration / NS_PER_US,
+            pid: process.pid,
+            tid: threadId,
+            args: args
+        });
+    }
+
+    // the report is built once all ts2abc processes are gone and have written their timing.
+    // A worker's exit is not the end of the compilation, it sends its records with takeRecorded
+    private static registerReport() {
+        if (TimingStatistics.reportRegistered) {
+            return;
+        }
+        TimingStatistics.reportRegistered = true;
+        TimingStatistics.heapStart = heapUsed();
+        TimingStatistics.observeGc();
+        if (isMainThread) {
+            process.on('exit', () => TimingStatistics.report());
+        }
+    }
+
+    // everything recorded so far, which is cleared, for a worker to send to the main thread
+    static takeRecorded(): TimingRecord {
+        let record: TimingRecord = {
+            phases: [],
+            functions: [],
+            events: TimingStatistics.events,
+            ts2abcTimingFiles: TimingStatistics.ts2abcTimingFiles,
+            heapPeak: TimingStatistics.heapPeak,
+            gcCount: TimingStatistics.gcCount,
+            gcTime: TimingStatistics.gcTime
+        };
+        TimingStatistics.phases.forEach((phaseTiming, phase) => record.phases.push([phase, phaseTiming]));
+        TimingStatistics.functions.forEach((funcTiming, funcName) => {
+            let phases: [string, number][] = [];
+            funcTiming.forEach((time, phase) => phases.push([phase, time]));
+            record.functions.push([funcName, phases]);
+        });
+
+        TimingStatistics.phases.clear();
+        TimingStatistics.functions.clear();
+        TimingStatistics.events = [];
+        TimingStatistics.ts2abcTimingFiles = [];
+        TimingStatistics.gcCount = 0;
+        TimingStatistics.gcTime = 0;
+        return record;
+    }
+
+    // adds what a worker recorded to the report of the main thread
+    static addRecorded(record: TimingRecord) {
+        TimingStatistics.registerReport();
+        record.phases.forEach(([phase, workerTiming]) => {
+            let phaseTiming = TimingStatistics.phases.get(phase);
+            if (!phaseTiming) {
+                phaseTiming = new PhaseTiming();
+                TimingStatistics.phases.set(phase, phaseTiming);
+            }
+            phaseTiming.time += workerTiming.time;
+            phaseTiming.count += workerTiming.count;
+            phaseTiming.heapGrowth += workerTiming.heapGrowth;
+        });
+        record.functions.forEach(([funcName, phases]) => {
+            let funcTiming = TimingStatistics.functions.get(funcName);
+            if (!funcTiming) {
+                funcTiming = new Map<string, number>();
+                TimingStatistics.functions.set(funcName, funcTiming);
+            }
+            phases.forEach(([phase, time]) => funcTiming!.set(phase, (funcTiming!.get(phase) || 0) + time));
+        });
+        TimingStatistics.events = TimingStatistics.events.concat(record.events);
+        TimingStatistics.ts2abcTimingFiles = TimingStatistics.ts2abcTimingFiles.concat(record.ts2abcTimingFiles);
+        // every worker has a heap of its own, the peak is that of the largest
+        TimingStatistics.heapPeak = Math.max(TimingStatistics.heapPeak, record.heapPeak);
+        TimingStatistics.gcCount += record.gcCount;
+        TimingStatistics.gcTime += record.gcTime;
+    }
+
+    // gc entries are delivered once the compilation yields to the event loop, while waiting for ts2abc
+    private static observeGc() {
+        let perfHooks = require('perf_hooks');
+        let observer = new perfHooks.PerformanceObserver((list: any) => {
+            list.getEntries().forEach((entry: any) => {
+                TimingStatistics.gcCount++;
+                TimingStatistics.gcTime += entry.duration;
+            });
+        });
+        observer.observe({ entryTypes: ['gc'] });
+    }
+
+    static getTs2abcTimingFile(outputBinName: string): string {
+        let timingFile = outputBinName + ".ts2abc.timing.json";
+        TimingStatistics.ts2abcTimingFiles.push(timingFile);
+        return timingFile;
+    }
+
+    private static mergeTs2abcTiming(): TraceEvent[] {
+        let ts2abcEvents: TraceEvent[] = [];
+        TimingStatistics.ts2abcTimingFiles.forEach((timingFile) => {
+            if (!fs.existsSync(timingFile)) {
+                LOGD("ts2abc wrote no timing file: ", timingFile);
+                return;
+            }
+            try {
+                let trace = JSON.parse(fs.readFileSync(timingFile, "utf-8"));
+                ts2abcEvents = ts2abcEvents.concat(trace.traceEvents);
+            } catch (err) {
+                LOGD("fail to read ts2abc timing: ", err);
+            }
+            fs.unlinkSync(timingFile);
+        });
+        return ts2abcEvents;
+    }
+
+    static report() {
+        let ts2abcEvents = TimingStatistics.mergeTs2abcTiming();
+        let ts2abcPhases: Map<string, PhaseTiming> = new Map<string, PhaseTiming>();
+        // what ts2abc counted in its phases, summed over all its processes
+        let ts2abcCounts: Map<string, number> = new Map<string, number>();
+        ts2abcEvents.forEach((event) => {
+            if (event.args) {
+                Object.keys(event.args).forEach((name) => {
+                    let key = event.name + ": " + name;
+                    ts2abcCounts.set(key, (ts2abcCounts.get(key) || 0) + event.args[name]);
+                });
+            }
+            let phaseTiming = ts2abcPhases.get(event.name);
+            if (!phaseTiming) {
+                phaseTiming = new PhaseTiming();
+                ts2abcPhases.set(event.name, phaseTiming);
+            }
+            phaseTiming.time += event.dur * NS_PER_US;
+            phaseTiming.count++;
+        });
+
+        console.log("\nTiming:\t====== ts2panda ======");
+        TimingStatistics.printPhases(TimingStatistics.phases, true);
+        console.log("heap used at start: " + TimingStatistics.heapStart + "\tpeak: " + TimingStatistics.heapPeak +
+                    "\tat exit: " + heapUsed());
+        console.log("gc: " + TimingStatistics.gcCount + " collections in " + TimingStatistics.gcTime.toFixed(3) + " ms");
+        if (ts2abcPhases.size > 0) {
+            console.log("\nTiming:\t====== ts2abc ======");
+            TimingStatistics.printPhases(ts2abcPhases, false);
+        }
+        if (ts2abcCounts.size > 0) {
+            console.log("\nts2abc counts:");
+            ts2abcCounts.forEach((value, key) => console.log(padEnd(key, 48) + value));
+        }
+        TimingStatistics.printTopFunctions();
+
+        let timingFile = CmdOptions.getOutputBinName() + ".timing.json";
+        let trace = { "traceEvents": TimingStatistics.events.concat(ts2abcEvents) };
+        fs.writeFileSync(timingFile, JSON.stringify(trace));
+        console.log("\ntrace of both processes written to " + timingFile);
+    }
+
+    private static printPhases(phases: Map<string, PhaseTiming>, withHeap: boolean) {
+        console.log(padEnd("phase", 24) + padEnd("time(ms)", 12) + padEnd("count", 10) + (withHeap ? "heap growth" : ""));
+        phases.forEach((phaseTiming, phase) => {
+            console.log(padEnd(phase, 24) + padEnd((phaseTiming.time / NS_PER_MS).toFixed(3), 12) +
+                        padEnd(String(phaseTiming.count), 10) + (withHeap ? phaseTiming.heapGrowth : ""));
+        });
+    }
+
+    private static printTopFunctions() {
+        let totals: { name: string, time: number }[] = [];
+        TimingStatistics.functions.forEach((funcTiming, funcName) => {
+            let time = 0;
+            funcTiming.forEach((phaseTime) => { time += phaseTime; });
+            totals.push({ name: funcName, time: time });
+        });
+        totals.sort((a, b) => b.time - a.time);
+
+        console.log("\nslowest functions (ms):");
+        totals.slice(0, TOP_FUNCTIONS_NUM).forEach((total) => {
+            let detail: string[] = [];
+            TimingStatistics.functions.get(total.name)!.forEach((phaseTime, phase) => {
+                detail.push(phase + " " + (phaseTime / NS_PER_MS).toFixed(3));
+            });
+            console.log(padEnd(total.name, 48) + padEnd((total.time / NS_PER_MS).toFixed(3), 12) + detail.join(", "));
+        });
+    }
+}
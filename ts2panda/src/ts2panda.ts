@@ -14,19 +14,12 @@
  */
 
 import { CmdOptions } from "./cmdOptions";
-import { DebugPosInfo } from "./debuginfo";
-import {
-    Imm,
-    IRNode,
-    Label,
-    OperandType,
-    VReg
-} from "./irnodes";
 import { LOGD } from "./log";
 import { PandaGen } from "./pandagen";
-import { CatchTable, Function, Ins, Signature } from "./pandasm";
+import { CatchTable, Metadata, Signature } from "./pandasm";
 import { generateCatchTables } from "./statement/tryStatement";
-import { escapeUnicode, isRangeInst, getRangeStartVregPos } from "./base/util";
+import { LABEL_PREFIX, PackedInsns } from "./base/packedInsns";
+import { addUnicodeEscape, escapeUnicode, writeToTs2abc } from "./base/util";
 
 const dollarSign: RegExp = /\$/g;
 
@@ -35,11 +28,13 @@ const JsonType = {
     "record": 1,
     "string": 2,
     "literal_arr": 3,
-    "options": 4
+    "options": 4,
+    "removed_function": 5
 };
 export class Ts2Panda {
     static strings: Set<string> = new Set();
-    static labelPrefix = "LABEL_";
+    static labelPrefix = LABEL_PREFIX;
+    static packedInsns: PackedInsns = new PackedInsns();
     static jsonString: string = "";
 
     constructor() {
@@ -49,68 +44,11 @@ export class Ts2Panda {
         return new Signature(pg.getParametersCount());
     }
 
-    static getFuncInsnsAndRegsNum(pg: PandaGen) {
-        let insns: Array<Ins> = [];
-        let labels: Array<string> = [];
-
-        pg.getInsns().forEach((insn: IRNode) => {
-            let insOpcode = insn.mnemonic;
-            let insRegs: Array<number> = [];
-            let insIds: Array<string> = [];
-            let insImms: Array<number> = [];
-            let insLabel: string = "";
-            let insDebugInfo: DebugPosInfo = new DebugPosInfo();
-
-            if (insn instanceof Label) {
-                insLabel = Ts2Panda.labelPrefix + insn.id;
-                labels.push(insLabel);
-            } else if (isRangeInst(insn)) {
-                // For DynRange insn we only pass the first vreg of continous vreg array
-                let operands = insn.operands;
-                insImms.push((<Imm>operands[0]).value);
-                insRegs.push((<VReg>operands[1]).num);
-                if (getRangeStartVregPos(insn) == 2) {
-                    insRegs.push((<VReg>operands[2]).num);
-                }
-            } else {
-                insn.operands.forEach((operand: OperandType) => {
-                    if (operand instanceof VReg) {
-                        let v = <VReg>operand;
-                        insRegs.push(v.num);
-                    } else if (operand instanceof Imm) {
-                        let imm = <Imm>operand;
-                        insImms.push(imm.value);
-                    } else if (typeof (operand) === "string") {
-                        insIds.push(operand);
-                        Ts2Panda.strings.add(operand);
-                    } else if (operand instanceof Label) {
-                        let labelName = Ts2Panda.labelPrefix + operand.id;
-                        insIds.push(labelName);
-                    }
-                });
-            }
-            insDebugInfo = insn.debugPosInfo;
-            if (CmdOptions.isDebugMode()) {
-                insDebugInfo.ClearMembersForDebugBuild();
-            } else {
-                insDebugInfo.ClearMembersForReleaseBuild();
-            }
-
-            insns.push(new Ins(
-                insOpcode,
-                insRegs.length == 0 ? undefined : insRegs,
-                insIds.length == 0 ? undefined : insIds,
-                insImms.length == 0 ? undefined : insImms,
-                insLabel === "" ? undefined : insLabel,
-                insDebugInfo,
-            ));
-        });
-
-        return {
-            insns: insns,
-            regsNum: (pg.getTotalRegsNum() - pg.getParametersCount()),
-            labels: labels
-        };
+    // packs the instructions of 'pg' into the shared buffers, its ids join the strings of the file
+    static packInsns(pg: PandaGen): PackedInsns {
+        Ts2Panda.packedInsns.encode(pg.getInsns());
+        Ts2Panda.packedInsns.getIds().forEach((id: string) => Ts2Panda.strings.add(id));
+        return Ts2Panda.packedInsns;
     }
 
     static dumpStringsArray(ts2abc: any) {
@@ -127,7 +65,7 @@ export class Ts2Panda {
             let jsonStrUnicode = escapeUnicode(JSON.stringify(strObject, null, 2));
             Ts2Panda.jsonString += jsonStrUnicode;
             jsonStrUnicode = "$" + jsonStrUnicode.replace(dollarSign, '#$') + "$";
-            ts2abc.stdio[3].write(jsonStrUnicode + '\n');
+            writeToTs2abc(ts2abc, jsonStrUnicode + '\n');
         });
     }
 
@@ -144,7 +82,7 @@ export class Ts2Panda {
             }
             let jsonLiteralArrUnicode = escapeUnicode(JSON.stringify(literalArrayObject, null, 2));
             jsonLiteralArrUnicode = "$" + jsonLiteralArrUnicode.replace(dollarSign, '#$') + "$";
-            ts2abc.stdio[3].write(jsonLiteralArrUnicode + '\n');
+            writeToTs2abc(ts2abc, jsonLiteralArrUnicode + '\n');
         });
     }
 
@@ -155,24 +93,28 @@ export class Ts2Panda {
             "debug_mode": CmdOptions.isDebugMode(),
             "log_enabled": CmdOptions.isEnableDebugLog(),
             "opt_level": CmdOptions.getOptLevel(),
-            "opt_log_level": CmdOptions.getOptLogLevel()
+            "opt_log_level": CmdOptions.getOptLogLevel(),
+            "incremental_delta": ts2abc.incrementalCache ? ts2abc.incrementalCache.hasBase() : false
         };
         let jsonOpt = JSON.stringify(options, null, 2);
         if (CmdOptions.isEnableDebugLog()) {
             Ts2Panda.jsonString += jsonOpt;
         }
         jsonOpt = "$" + jsonOpt.replace(dollarSign, '#$') + "$";
-        ts2abc.stdio[3].write(jsonOpt + '\n');
+        writeToTs2abc(ts2abc, jsonOpt + '\n');
     }
 
-    static dumpPandaGen(pg: PandaGen, ts2abc: any): void {
+    // the "func_body" of the piece of 'pg': the fields of a pandasm Function, with the instructions
+    // written straight from the packed buffers
+    static serializeFuncBody(pg: PandaGen, debugInfoCollected: boolean): string {
         let funcName = pg.internalName;
         let funcSignature = Ts2Panda.getFuncSignature(pg);
-        let funcInsnsAndRegsNum = Ts2Panda.getFuncInsnsAndRegsNum(pg);
+        let packedInsns = Ts2Panda.packInsns(pg);
+        let regsNum = pg.getTotalRegsNum() - pg.getParametersCount();
         let sourceFile = pg.getSourceFileDebugInfo();
 
         let variables, sourceCode;
-        if (CmdOptions.isDebugMode()) {
+        if (debugInfoCollected) {
             variables = pg.getVariableDebugInfoArray();
             sourceCode = pg.getSourceCodeDebugInfo();
         } else {
@@ -180,22 +122,12 @@ export class Ts2Panda {
             sourceCode = undefined;
         }
 
-        let func = new Function(
-            funcName,
-            funcSignature,
-            funcInsnsAndRegsNum.regsNum,
-            funcInsnsAndRegsNum.insns,
-            funcInsnsAndRegsNum.labels,
-            variables,
-            sourceFile,
-            sourceCode,
-        );
-        let catchTables = generateCatchTables(pg.getCatchMap());
-        catchTables.forEach((catchTable) => {
+        let catchTables: Array<CatchTable> = [];
+        generateCatchTables(pg.getCatchMap()).forEach((catchTable) => {
             let catchBeginLabel = catchTable.getCatchBeginLabel();
             let labelPairs = catchTable.getLabelPairs();
             labelPairs.forEach((labelPair) => {
-                func.catchTables.push(new CatchTable(
+                catchTables.push(new CatchTable(
                     Ts2Panda.labelPrefix + labelPair.getBeginLabel().id,
                     Ts2Panda.labelPrefix + labelPair.getEndLabel().id,
                     Ts2Panda.labelPrefix + catchBeginLabel.id
@@ -203,18 +135,56 @@ export class Ts2Panda {
             });
         });
 
-        LOGD(func);
+        return "{\"name\":" + JSON.stringify(funcName) +
+            ",\"signature\":" + JSON.stringify(funcSignature) +
+            ",\"ins\":" + packedInsns.serializeInsns(debugInfoCollected) +
+            ",\"labels\":" + packedInsns.serializeLabels() +
+            ",\"regs_num\":" + regsNum +
+            ",\"metadata\":" + JSON.stringify(new Metadata()) +
+            ",\"catchTables\":" + JSON.stringify(catchTables) +
+            (variables === undefined ? "" : ",\"variables\":" + JSON.stringify(variables)) +
+            ",\"sourceFile\":" + JSON.stringify(sourceFile) +
+            (sourceCode === undefined ? "" : ",\"sourceCode\":" + JSON.stringify(sourceCode)) + "}";
+    }
+
+    static dumpPandaGen(pg: PandaGen, ts2abc: any): void {
+        let funcName = pg.internalName;
+        let funcBody = Ts2Panda.serializeFuncBody(pg, CmdOptions.isDebugInfoCollected());
+
+        LOGD(funcBody);
 
-        let funcObject = {
-            "type": JsonType.function,
-            "func_body": func
+        // the json has no line breaks, so it is escaped as one line
+        let jsonFuncUnicode = "{\"type\":" + JsonType.function + ",\"func_body\":" + funcBody + "}";
+        if (jsonFuncUnicode.indexOf("\\u") != -1) {
+            jsonFuncUnicode = addUnicodeEscape(jsonFuncUnicode);
         }
-        let jsonFuncUnicode = escapeUnicode(JSON.stringify(funcObject, null, 2));
         if (CmdOptions.isEnableDebugLog()) {
             Ts2Panda.jsonString += jsonFuncUnicode;
         }
-        jsonFuncUnicode = "$" + jsonFuncUnicode.replace(dollarSign, '#$') + "$";
-        ts2abc.stdio[3].write(jsonFuncUnicode + '\n');
+        jsonFuncUnicode = jsonFuncUnicode.replace(dollarSign, '#$');
+        if (ts2abc.incrementalCache && ts2abc.incrementalCache.isUnchanged(funcName, jsonFuncUnicode)) {
+            return;
+        }
+        writeToTs2abc(ts2abc, "$" + jsonFuncUnicode + "$" + '\n');
+    }
+
+    static dumpRemovedFunctions(ts2abc: any): void {
+        if (!ts2abc.incrementalCache) {
+            return;
+        }
+
+        ts2abc.incrementalCache.getRemovedFunctions().forEach(function(funcName: string) {
+            let removedFuncObject = {
+                "type": JsonType.removed_function,
+                "func_name": funcName
+            }
+            let jsonRemovedFunc = JSON.stringify(removedFuncObject, null, 2);
+            if (CmdOptions.isEnableDebugLog()) {
+                Ts2Panda.jsonString += jsonRemovedFunc;
+            }
+            jsonRemovedFunc = "$" + jsonRemovedFunc.replace(dollarSign, '#$') + "$";
+            writeToTs2abc(ts2abc, jsonRemovedFunc + '\n');
+        });
     }
 
     static clearDumpData() {
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import { expect } from 'chai';
+import 'mocha';
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
+import { BuildManifest } from "../src/base/buildManifest";
+
+describe("BuildManifest", function () {
+    let dir: string;
+    let manifestFile: string;
+    let fileA: string;
+    let fileB: string;
+    let options = { allowJs: true };
+
+    function build(outputOptions: string) {
+        let manifest = new BuildManifest(manifestFile, outputOptions);
+        [[fileA, ["./b"]], [fileB, []]].forEach((item: any) => {
+            let output = item[0].replace(/\.js$/, ".abc");
+            fs.writeFileSync(output, "");
+            BuildManifest.addBuilt(item[0], BuildManifest.createEntry(item[0], output, item[1], options)!);
+        });
+        manifest.save();
+        BuildManifest.takeBuilt();
+    }
+
+    beforeEach(function () {
+        dir = fs.mkdtempSync(path.join(os.tmpdir(), "ts2panda-buildinfo-"));
+        manifestFile = path.join(dir, "a.abc.buildinfo");
+        fileA = path.join(dir, "a.js");
+        fileB = path.join(dir, "b.js");
+        fs.writeFileSync(fileA, "import { b } from './b';\nprint(b);\n");
+        fs.writeFileSync(fileB, "export let b = 1;\n");
+    });
+
+    afterEach(function () {
+        fs.readdirSync(dir).forEach(file => fs.unlinkSync(path.join(dir, file)));
+        fs.rmdirSync(dir);
+    });
+
+    it("rebuilds everything without build info", function () {
+        let manifest = new BuildManifest(manifestFile, "options");
+        expect(manifest.isAllUpToDate([fileA])).to.be.false;
+        expect(manifest.filterDirty([fileA, fileB])).to.deep.equal([fileA, fileB]);
+    });
+
+    it("skips unchanged files", function () {
+        build("options");
+        let manifest = new BuildManifest(manifestFile, "options");
+        expect(manifest.isAllUpToDate([fileA])).to.be.true;
+    });
+
+    it("rebuilds the importers of a changed file", function () {
+        build("options");
+        fs.writeFileSync(fileB, "export let b = 2;\n");
+        let manifest = new BuildManifest(manifestFile, "options");
+        expect(manifest.isAllUpToDate([fileA])).to.be.false;
+        expect(manifest.filterDirty([fileA, fileB])).to.deep.equal([fileA, fileB]);
+    });
+
+    it("rebuilds a file whose output is gone", function () {
+        build("options");
+        fs.unlinkSync(path.join(dir, "b.abc"));
+        let manifest = new BuildManifest(manifestFile, "options");
+        expect(manifest.filterDirty([fileA, fileB])).to.deep.equal([fileA, fileB]);
+    });
+
+    it("rebuilds everything when the options changed", function () {
+        build("options");
+        let manifest = new BuildManifest(manifestFile, "other options");
+        expect(manifest.filterDirty([fileA, fileB])).to.deep.equal([fileA, fileB]);
+    });
+});
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import { expect } from 'chai';
+import 'mocha';
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
+import { IncrementalCache } from "../src/base/incrementalCache";
+
+const indexJs = path.resolve(__dirname, "../src/index.js");
+const js2abc = path.resolve(__dirname, "../bin/js2abc");
+
+function funcPiece(name: string, regsNum: number): string {
+    let funcObject = {
+        "type": 0,
+        "func_body": { "name": name, "regs_num": regsNum, "ins": [{ "op": "lda.str", "ids": ["a$b"] }] }
+    };
+    return JSON.stringify(funcObject, null, 2).replace(/\$/g, '#$');
+}
+
+describe("IncrementalCache", function () {
+    let dir: string;
+    let output: string;
+
+    beforeEach(function () {
+        dir = fs.mkdtempSync(path.join(os.tmpdir(), "ts2abc-incremental-"));
+        output = path.join(dir, "test.abc");
+    });
+
+    afterEach(function () {
+        fs.readdirSync(dir).forEach(file => fs.unlinkSync(path.join(dir, file)));
+        fs.rmdirSync(dir);
+    });
+
+    it("does a full build without a previous output", function () {
+        fs.writeFileSync(output + ".pieces", "$" + funcPiece("func_main_0", 1) + "$\n");
+        let cache = new IncrementalCache(output);
+        expect(cache.hasBase()).to.be.false;
+        expect(cache.isUnchanged("func_main_0", funcPiece("func_main_0", 1))).to.be.false;
+    });
+
+    it("skips unchanged functions and reports removed ones", function () {
+        fs.writeFileSync(output, "");
+        let pieces = ["$" + '{\n  "type": 4\n}\n' + "$\n"];
+        ["func_main_0", "foo", "bar"].forEach(name => pieces.push("$" + funcPiece(name, 1) + "$\n"));
+        fs.writeFileSync(output + ".pieces", pieces.join(""));
+
+        let cache = new IncrementalCache(output);
+        expect(cache.hasBase()).to.be.true;
+        expect(cache.isUnchanged("func_main_0", funcPiece("func_main_0", 1))).to.be.true;
+        expect(cache.isUnchanged("foo", funcPiece("foo", 2))).to.be.false;
+        expect(cache.isUnchanged("baz", funcPiece("baz", 1))).to.be.false;
+        expect(cache.getRemovedFunctions()).to.deep.equal(["bar"]);
+    });
+});
+
+describe("incremental build", function () {
+    let dir: string;
+    let source: string;
+
+    function compile(output: string, incremental: boolean, extraArgs: string[] = []) {
+        let args = ["--expose-gc", indexJs, source, "--output", output].concat(extraArgs);
+        if (incremental) {
+            args.push("--incremental");
+        }
+        let result = require('child_process').spawnSync(process.execPath, args, { stdio: 'inherit' });
+        expect(result.status).to.equal(0);
+    }
+
+    function writeSource(value: string) {
+        fs.writeFileSync(source,
+            "function foo() {\n    return " + value + ";\n}\n" +
+            "function bar(a) {\n    return [a, 'bar', 1.5];\n}\n" +
+            "print(foo(), bar(1));\n");
+    }
+
+    // what ts2abc counted in its phase 'phase', from the trace of --show-statistics timing
+    function ts2abcCount(output: string, phase: string, name: string): number {
+        let trace = JSON.parse(fs.readFileSync(output + ".timing.json", "utf-8"));
+        let events = trace.traceEvents.filter((event: any) => event.cat == "ts2abc" && event.name == phase);
+        expect(events.length).to.equal(1);
+        return events[0].args ? (events[0].args[name] || 0) : 0;
+    }
+
+    before(function () {
+        // the test build copies ts2abc next to the frontend, see tests/BUILD.gn
+        expect(fs.existsSync(js2abc), "ts2abc is not built: " + js2abc).to.be.true;
+    });
+
+    beforeEach(function () {
+        dir = fs.mkdtempSync(path.join(os.tmpdir(), "ts2abc-incremental-build-"));
+        source = path.join(dir, "test.js");
+    });
+
+    afterEach(function () {
+        fs.readdirSync(dir).forEach(file => fs.unlinkSync(path.join(dir, file)));
+        fs.rmdirSync(dir);
+    });
+
+    it("emits what a clean build emits after a function changed", function () {
+        this.timeout(60000);
+        let incrementalOutput = path.join(dir, "incremental.abc");
+        let cleanOutput = path.join(dir, "clean.abc");
+
+        writeSource("'first'");
+        compile(incrementalOutput, true);
+        writeSource("{ value: 'second' }");
+        compile(incrementalOutput, true);
+        compile(cleanOutput, false);
+
+        expect(fs.readFileSync(incrementalOutput).equals(fs.readFileSync(cleanOutput))).to.be.true;
+    });
+
+    it("takes the unchanged functions from the cache", function () {
+        this.timeout(60000);
+        let output = path.join(dir, "test.abc");
+
+        writeSource("'first'");
+        compile(output, true);
+        // only foo changes, bar and func_main_0 are not sent again
+        writeSource("'second'");
+        compile(output, true, ["--show-statistics", "timing"]);
+
+        expect(ts2abcCount(output, "merge incremental cache", "reused functions")).to.equal(2);
+    });
+});
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import { expect } from 'chai';
+import 'mocha';
+import { DebugPosInfo } from "../src/debuginfo";
+import { LABEL_PREFIX, PackedInsns } from "../src/base/packedInsns";
+import { getRangeStartVregPos, isRangeInst } from "../src/base/util";
+import { Imm, IRNode, Label, OperandType, VReg } from "../src/irnodes";
+import { PandaGen } from "../src/pandagen";
+import { CacheExpander } from "../src/pass/cacheExpander";
+import { CatchTable, Function, Ins } from "../src/pandasm";
+import { RegAlloc } from "../src/regAllocator";
+import { generateCatchTables } from "../src/statement/tryStatement";
+import { Ts2Panda } from "../src/ts2panda";
+import { compileAllSnippet } from "./utils/base";
+
+function compileMain(snippet: string): PandaGen {
+    let pandaGens = compileAllSnippet(snippet, [new CacheExpander(), new RegAlloc()]);
+    return pandaGens.filter((pg) => pg.internalName == "func_main_0")[0];
+}
+
+// an instruction the way it was serialized before the packed buffers: a pandasm Ins per IRNode
+function referenceIns(insn: IRNode, debugMode: boolean): Ins {
+    let insRegs: Array<number> = [];
+    let insIds: Array<string> = [];
+    let insImms: Array<number> = [];
+    let insLabel: string = "";
+
+    if (insn instanceof Label) {
+        insLabel = LABEL_PREFIX + insn.id;
+    } else if (isRangeInst(insn)) {
+        let operands = insn.operands;
+        insImms.push((<Imm>operands[0]).value);
+        insRegs.push((<VReg>operands[1]).num);
+        if (getRangeStartVregPos(insn) == 2) {
+            insRegs.push((<VReg>operands[2]).num);
+        }
+    } else {
+        insn.operands.forEach((operand: OperandType) => {
+            if (operand instanceof VReg) {
+                insRegs.push(operand.num);
+            } else if (operand instanceof Imm) {
+                insImms.push(operand.value);
+            } else if (typeof (operand) === "string") {
+                insIds.push(operand);
+            } else if (operand instanceof Label) {
+                insIds.push(LABEL_PREFIX + operand.id);
+            }
+        });
+    }
+
+    // a copy, the old path cleared the members of the instruction's own info
+    let posInfo = insn.debugPosInfo;
+    let insDebugInfo = new DebugPosInfo();
+    insDebugInfo.setBoundLeft(posInfo.getBoundLeft()!);
+    insDebugInfo.setBoundRight(posInfo.getBoundRight()!);
+    insDebugInfo.setSourecLineNum(posInfo.getSourceLineNum());
+    insDebugInfo.setSourecColumnNum(posInfo.getSourceColumnNum());
+    if (debugMode) {
+        insDebugInfo.ClearMembersForDebugBuild();
+    } else {
+        insDebugInfo.ClearMembersForReleaseBuild();
+    }
+
+    return new Ins(
+        insn.mnemonic,
+        insRegs.length == 0 ? undefined : insRegs,
+        insIds.length == 0 ? undefined : insIds,
+        insImms.length == 0 ? undefined : insImms,
+        insLabel === "" ? undefined : insLabel,
+        insDebugInfo,
+    );
+}
+
+function referenceFunction(pg: PandaGen, debugMode: boolean): Function {
+    let insns = pg.getInsns();
+    let labels = insns.filter((insn) => insn instanceof Label).map((insn) => LABEL_PREFIX + (<Label>insn).id);
+    let func = new Function(
+        pg.internalName,
+        Ts2Panda.getFuncSignature(pg),
+        pg.getTotalRegsNum() - pg.getParametersCount(),
+        insns.map((insn) => referenceIns(insn, debugMode)),
+        labels,
+        debugMode ? pg.getVariableDebugInfoArray() : undefined,
+        pg.getSourceFileDebugInfo(),
+        debugMode ? pg.getSourceCodeDebugInfo() : undefined
+    );
+    generateCatchTables(pg.getCatchMap()).forEach((catchTable) => {
+        catchTable.getLabelPairs().forEach((labelPair) => {
+            func.catchTables.push(new CatchTable(
+                LABEL_PREFIX + labelPair.getBeginLabel().id,
+                LABEL_PREFIX + labelPair.getEndLabel().id,
+                LABEL_PREFIX + catchTable.getCatchBeginLabel().id
+            ));
+        });
+    });
+    return func;
+}
+
+// compact json of both, so that the order of the fields is compared too
+function expectSameJson(packedJson: string, reference: any) {
+    expect(JSON.stringify(JSON.parse(packedJson))).to.equal(JSON.stringify(reference));
+}
+
+function checkPacked(packed: PackedInsns, insns: IRNode[]) {
+    expect(packed.getInsCount()).to.equal(insns.length);
+    expectSameJson(packed.serializeInsns(true), insns.map((insn) => referenceIns(insn, true)));
+    expectSameJson(packed.serializeInsns(false), insns.map((insn) => referenceIns(insn, false)));
+    expectSameJson(packed.serializeLabels(),
+        insns.filter((insn) => insn instanceof Label).map((insn) => LABEL_PREFIX + (<Label>insn).id));
+}
+
+describe("PackedInsns", function () {
+    it("serializes the instructions of a function", function () {
+        let pg = compileMain("let a = 1;\nif (a) {\n    a = 'str';\n}\nprint(a, a);\n");
+        let packed = new PackedInsns();
+        packed.encode(pg.getInsns());
+
+        checkPacked(packed, pg.getInsns());
+        expect(packed.getIds()).to.include("print");
+        expect(JSON.parse(packed.serializeInsns(false))[0].debug_pos_info.boundLeft).to.be.undefined;
+    });
+
+    it("grows and reuses its buffers", function () {
+        let body = "let a = 0;\n";
+        for (let i = 0; i < 2000; i++) {
+            body += "a = a + " + i + ";\n";
+        }
+        let large = compileMain(body);
+        let small = compileMain("let b = 1;\n");
+        let packed = new PackedInsns();
+
+        packed.encode(large.getInsns());
+        expect(large.getInsns().length).to.be.above(1024);
+        checkPacked(packed, large.getInsns());
+
+        packed.encode(small.getInsns());
+        checkPacked(packed, small.getInsns());
+    });
+});
+
+describe("Ts2Panda.serializeFuncBody", function () {
+    // ids and imms of every kind, range calls and creates, jumps of branches and loops, try/catch/finally
+    let snippet =
+        "function sum(a, b, c, d) {\n" +
+        "    return a + b + c + d;\n" +
+        "}\n" +
+        "function Point(x, y, z) {\n" +
+        "    this.x = x;\n" +
+        "    this.y = y;\n" +
+        "    this.z = z;\n" +
+        "}\n" +
+        "let o = { x: 1, 'y$': 'str', z: 1.5, w: -2147483649 };\n" +
+        "let p = new Point(1, 2, 3);\n" +
+        "let { x, ...rest } = o;\n" +
+        "try {\n" +
+        "    sum(o.x, o.z, 3, 4);\n" +
+        "    o.toString(1, 2, 3, 4);\n" +
+        "} catch (e) {\n" +
+        "    print(e);\n" +
+        "} finally {\n" +
+        "    o.x = 0;\n" +
+        "}\n" +
+        "for (let i = 0; i < 10; i++) {\n" +
+        "    if (i % 2) {\n" +
+        "        continue;\n" +
+        "    }\n" +
+        "    o.x += i;\n" +
+        "}\n" +
+        "while (o.x > 0) {\n" +
+        "    o.x--;\n" +
+        "}\n";
+
+    [false, true].forEach((debugMode) => {
+        it("writes what JSON.stringify wrote of a pandasm Function, " + (debugMode ? "debug" : "release"), function () {
+            let pandaGens = compileAllSnippet(snippet, [new CacheExpander(), new RegAlloc()]);
+            let insns: IRNode[] = [];
+            pandaGens.forEach((pg) => {
+                expectSameJson(Ts2Panda.serializeFuncBody(pg, debugMode), referenceFunction(pg, debugMode));
+                insns = insns.concat(pg.getInsns());
+            });
+
+            // the snippet has to cover what it is meant to
+            expect(insns.filter((insn) => isRangeInst(insn)).length).to.be.above(2);
+            expect(insns.filter((insn) => insn instanceof Label).length).to.be.above(4);
+            let main = pandaGens.filter((pg) => pg.internalName == "func_main_0")[0];
+            expect(generateCatchTables(main.getCatchMap()).length).to.be.above(0);
+        });
+    });
+});
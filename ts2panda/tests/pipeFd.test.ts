@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import { expect } from 'chai';
+import 'mocha';
+import { getPipeFd, writeToPipeFd } from "../src/base/pipeFd";
+
+describe("pipeFd", function () {
+    it("finds no fd without a usable handle", function () {
+        expect(getPipeFd(undefined)).to.equal(-1);
+        expect(getPipeFd({})).to.equal(-1);
+        expect(getPipeFd({ _handle: {} })).to.equal(-1);
+        expect(getPipeFd({ _handle: { fd: -1 } })).to.equal(-1);
+        expect(getPipeFd({ _handle: { fd: "3" } })).to.equal(-1);
+        expect(getPipeFd({ _handle: { fd: 3 } })).to.equal(3);
+    });
+
+    it("writes more than a pipe holds to a slow reader", function (done) {
+        this.timeout(10000);
+        let spawn = require('child_process').spawn;
+        // counts what it reads, after a delay which fills the pipe
+        let reader = spawn(process.execPath, ["-e",
+            "let n = 0; setTimeout(() => { process.stdin.on('data', (d) => { n += d.length; });" +
+            "process.stdin.on('end', () => process.stdout.write(String(n))); }, 100);"],
+            { stdio: ['pipe', 'pipe', 'inherit'] });
+        let fd = getPipeFd(reader.stdin);
+        if (fd < 0) {
+            // node keeps the fd of pipes private on this platform
+            reader.kill();
+            this.skip();
+            return;
+        }
+
+        let size = 4 * 1024 * 1024;
+        let stallTime = writeToPipeFd(fd, Buffer.alloc(size, "x"));
+        reader.stdin.end();
+
+        expect(stallTime).to.be.above(0);
+        let output = "";
+        reader.stdout.on('data', (data: Buffer) => { output += data.toString(); });
+        reader.on('exit', () => {
+            expect(Number(output)).to.equal(size);
+            done();
+        });
+    });
+});
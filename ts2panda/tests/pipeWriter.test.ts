@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import { expect } from 'chai';
+import 'mocha';
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
+import { Writable } from "stream";
+import { PipeWriter } from "../src/base/pipeWriter";
+
+class FakeStream {
+    writes: Buffer[] = [];
+    ended: boolean = false;
+    full: boolean = false;
+
+    write(buffer: Buffer) {
+        this.writes.push(buffer);
+        return !this.full;
+    }
+
+    end() {
+        this.ended = true;
+    }
+}
+
+describe("PipeWriter", function () {
+    it("coalesces pieces into few writes", function () {
+        let stream = new FakeStream();
+        let writer = new PipeWriter(stream);
+        let expected = "";
+        for (let i = 0; i < 1000; i++) {
+            let piece = "$" + JSON.stringify({ "type": 2, "string": "str" + i }) + "$\n";
+            writer.write(piece);
+            expected += piece;
+        }
+        writer.end();
+
+        expect(stream.ended).to.be.true;
+        expect(stream.writes.length).to.equal(1);
+        expect(Buffer.concat(stream.writes).toString()).to.equal(expected);
+        expect(writer.getBytesWritten()).to.equal(Buffer.byteLength(expected));
+    });
+
+    it("keeps the order of pieces larger than a chunk", function () {
+        let stream = new FakeStream();
+        let writer = new PipeWriter(stream);
+        let large = new Array(1024 * 1024 + 1).join("x");
+        writer.write("a");
+        writer.write(large);
+        writer.write("b");
+        writer.end();
+
+        expect(Buffer.concat(stream.writes).toString()).to.equal("a" + large + "b");
+        expect(writer.getWriteCount()).to.equal(3);
+    });
+
+    it("writes to the fd of the stream directly", function () {
+        let fileName = path.join(os.tmpdir(), "ts2panda-pipewriter-" + process.pid);
+        let fd = fs.openSync(fileName, "w");
+        let stream = new FakeStream();
+        (<any>stream)._handle = { fd: fd };
+        let writer = new PipeWriter(stream);
+        writer.write("$piece1$\n");
+        writer.write("$piece2$\n");
+        writer.end();
+        fs.closeSync(fd);
+
+        expect(stream.writes.length).to.equal(0);
+        expect(fs.readFileSync(fileName, "utf-8")).to.equal("$piece1$\n$piece2$\n");
+        expect(writer.getStallTime()).to.equal(0);
+        fs.unlinkSync(fileName);
+    });
+
+    it("falls back to the stream without a fd", function () {
+        let stream = new FakeStream();
+        (<any>stream)._handle = {};
+        let writer = new PipeWriter(stream);
+        writer.write("$piece$\n");
+        writer.end();
+
+        expect(Buffer.concat(stream.writes).toString()).to.equal("$piece$\n");
+    });
+
+    it("spills what a full stream can not hold to a file", function (done) {
+        let received: Buffer[] = [];
+        // completes no write before the event loop runs, as while compiling
+        let stream = new Writable({
+            highWaterMark: 1024,
+            write(chunk: Buffer, encoding: string, callback: () => void) {
+                received.push(chunk);
+                setImmediate(callback);
+            }
+        });
+        let writer = new PipeWriter(stream, 1024 * 1024);
+        let expected = "";
+        for (let i = 0; i < 6; i++) {
+            let large = new Array(512 * 1024 + 1).join(String(i));
+            writer.write(large);
+            expected += large;
+        }
+        writer.end();
+
+        expect(writer.getSpilledBytes()).to.be.above(0);
+        expect(writer.getSpilledBytes()).to.be.below(expected.length);
+        stream.on('finish', () => {
+            expect(Buffer.concat(received).toString()).to.equal(expected);
+            done();
+        });
+    });
+
+    it("lets a stream with room take more than the limit overall", function () {
+        let stream = new FakeStream();
+        let writer = new PipeWriter(stream, 1024 * 1024);
+        let large = new Array(512 * 1024 + 1).join("x");
+        for (let i = 0; i < 8; i++) {
+            writer.write(large);
+        }
+        writer.end();
+
+        expect(writer.getBytesWritten()).to.equal(8 * large.length);
+    });
+});
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import { expect } from 'chai';
+import 'mocha';
+import * as fs from "fs";
+import * as path from "path";
+import { ShmTransport } from "../src/base/shmTransport";
+
+describe("ShmTransport", function () {
+    it("writes into a private directory and cleans it up", function () {
+        let transport = ShmTransport.create();
+        if (!transport) {
+            // no shared memory filesystem on this host
+            this.skip();
+            return;
+        }
+
+        let dir = path.dirname(transport.fileName);
+        expect(fs.statSync(dir).mode & 0o777).to.equal(0o700);
+        transport.write("$piece$\n");
+        transport.close();
+        expect(fs.readFileSync(transport.fileName, "utf-8")).to.equal("$piece$\n");
+
+        transport.remove();
+        expect(fs.existsSync(dir)).to.be.false;
+    });
+
+    it("never reuses a path", function () {
+        let first = ShmTransport.create();
+        let second = ShmTransport.create();
+        if (!first || !second) {
+            this.skip();
+            return;
+        }
+
+        expect(path.dirname(first.fileName)).to.not.equal(path.dirname(second.fileName));
+        first.close();
+        second.close();
+        first.remove();
+        second.remove();
+    });
+});
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# coding: utf-8
+
+"""
+Copyright (c) 2021 Huawei Device Co., Ltd.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Description: Record the piece streams of the benchmark corpus. Every '.js' file of
+benchmark/streams is compiled by the frontend with --incremental, which makes ts2abc
+keep the piece stream it received, and that stream is saved next to the source.
+"""
+
+import argparse
+import glob
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+
+def parse_args():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--frontend-tool-path', required=True,
+                        help='the built frontend, the directory holding src/index.js and bin/js2abc')
+    parser.add_argument('--node', default='node',
+                        help='path to nodejs executable')
+    parser.add_argument('--streams-dir',
+                        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), 'streams'),
+                        help='directory of the corpus')
+    return parser.parse_args()
+
+
+def record_stream(args, src_js, out_dir):
+    name = os.path.splitext(os.path.basename(src_js))[0]
+    # a fresh output, so that the stream is that of a full build
+    dst_file = os.path.join(out_dir, name + '.abc')
+    cmd = [args.node, '--expose-gc',
+           os.path.join(args.frontend_tool_path, 'src', 'index.js'),
+           src_js, '-o', dst_file, '--incremental']
+    print(' '.join(cmd))
+    if subprocess.call(cmd) != 0:
+        return False
+
+    pieces = dst_file + '.pieces'
+    if not os.path.isfile(pieces):
+        print('ts2abc kept no piece stream: ' + pieces)
+        return False
+    shutil.copyfile(pieces, os.path.join(args.streams_dir, name + '.pieces'))
+    return True
+
+
+def main():
+    args = parse_args()
+    sources = sorted(glob.glob(os.path.join(args.streams_dir, '*.js')))
+    out_dir = tempfile.mkdtemp(prefix='ts2abc-streams-')
+    try:
+        for src_js in sources:
+            if not record_stream(args, src_js, out_dir):
+                return 1
+    finally:
+        shutil.rmtree(out_dir)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,9 @@
+function add(a, b) {
+    return a + b;
+}
+var sum = 0;
+for (var i = 0; i < 3; i++) {
+    sum = add(sum, i);
+}
+var point = { x: 1, y: 2.5, name: "p" };
+print(sum, point.name);
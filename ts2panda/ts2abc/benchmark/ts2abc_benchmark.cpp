@@ -0,0 +1,374 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Microbenchmarks for the hot paths of ts2abc: piece splitting, json parsing of the
+// pieces, string conversion, opcode lookup, literal parsing and emitting.
+// Every benchmark reports ns/op, heap allocations/op and, where it consumes input, throughput.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "assembly-emitter.h"
+#include "assembly-program.h"
+#include "file.h"
+#include "json/json.h"
+#include "mem_stat.h"
+#include "ts2abc.h"
+#include "utils/pandargs.h"
+
+// the recorded corpus, the build points it at benchmark/streams
+#ifndef TS2ABC_BENCHMARK_STREAMS
+#define TS2ABC_BENCHMARK_STREAMS ""
+#endif
+
+namespace {
+    size_t g_sink = 0;
+
+    const size_t SYNTHETIC_FUNCTIONS = 200;
+    const size_t SYNTHETIC_INSTRUCTIONS = 50;
+    const size_t SYNTHETIC_STRINGS = 500;
+    const size_t SYNTHETIC_LITERAL_ARRAYS = 50;
+    const size_t LITERAL_KINDS = 3;  // string, integer and double
+}
+
+namespace panda::ts2abc::benchmark {
+class Runner {
+public:
+    Runner(int64_t minTimeMs, const std::string &filter) : minTime_(minTimeMs * NS_PER_MS), filter_(filter) {}
+
+    // 'bytesPerOp' is the size of the consumed input, 0 if throughput is meaningless
+    template <typename Func>
+    void Run(const std::string &name, size_t bytesPerOp, Func &&func)
+    {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+            return;
+        }
+
+        // warm up caches and lazily initialized tables
+        func();
+
+        size_t iterations = 0;
+        size_t batch = 1;
+        size_t allocCount = GetAllocationCount();
+        size_t allocBytes = GetAllocatedBytes();
+        auto start = std::chrono::steady_clock::now();
+        int64_t elapsed = 0;
+        while (elapsed < minTime_) {
+            for (size_t i = 0; i < batch; i++) {
+                func();
+            }
+            iterations += batch;
+            batch *= 2;
+            elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+        double nsPerOp = static_cast<double>(elapsed) / iterations;
+        std::cout << std::left << std::setw(NAME_WIDTH) << name << std::right
+                  << std::setw(COLUMN_WIDTH) << iterations
+                  << std::setw(COLUMN_WIDTH) << std::fixed << std::setprecision(1) << nsPerOp
+                  << std::setw(COLUMN_WIDTH) << static_cast<double>(GetAllocationCount() - allocCount) / iterations
+                  << std::setw(COLUMN_WIDTH) << static_cast<double>(GetAllocatedBytes() - allocBytes) / iterations;
+        if (bytesPerOp != 0) {
+            std::cout << std::setw(COLUMN_WIDTH) << bytesPerOp * NS_PER_S / nsPerOp / BYTES_PER_MB;
+        }
+        std::cout << std::endl;
+    }
+
+    static void PrintHeader()
+    {
+        std::cout << std::left << std::setw(NAME_WIDTH) << "benchmark" << std::right
+                  << std::setw(COLUMN_WIDTH) << "iterations" << std::setw(COLUMN_WIDTH) << "ns/op"
+                  << std::setw(COLUMN_WIDTH) << "allocs/op" << std::setw(COLUMN_WIDTH) << "bytes/op"
+                  << std::setw(COLUMN_WIDTH) << "MB/s" << std::endl;
+    }
+
+private:
+    static constexpr int64_t NS_PER_MS = 1000000;
+    static constexpr double NS_PER_S = 1e9;
+    static constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+    static constexpr int NAME_WIDTH = 44;
+    static constexpr int COLUMN_WIDTH = 14;
+
+    int64_t minTime_;
+    std::string filter_;
+};
+
+// the frontend pretty prints every piece with JSON.stringify(obj, null, 2), keep the same shape
+static std::string Stringify(const Json::Value &value)
+{
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "  ";
+    return Json::writeString(writerBuilder, value);
+}
+
+static Json::Value MakeInstruction(size_t idx)
+{
+    static const char *OPS[] = { "lda.dyn", "sta.dyn", "mov.dyn", "ldai.dyn", "lda.str" };
+    const size_t opsNum = sizeof(OPS) / sizeof(OPS[0]);
+    const size_t regsNum = 8;
+
+    Json::Value ins;
+    std::string op = OPS[idx % opsNum];
+    ins["op"] = op;
+    if (op == "mov.dyn") {
+        ins["regs"].append(static_cast<Json::UInt>(idx % regsNum));
+        ins["regs"].append(static_cast<Json::UInt>((idx + 1) % regsNum));
+    } else if (op == "ldai.dyn") {
+        ins["imms"].append(static_cast<Json::Int>(idx));
+    } else if (op == "lda.str") {
+        ins["ids"].append("identifier_" + std::to_string(idx));
+    } else {
+        ins["regs"].append(static_cast<Json::UInt>(idx % regsNum));
+    }
+    ins["debug_pos_info"]["lineNum"] = static_cast<Json::Int>(idx);
+    return ins;
+}
+
+static std::string MakeFunctionPiece(size_t funcIdx, size_t insNum)
+{
+    Json::Value func;
+    func["name"] = "func_" + std::to_string(funcIdx);
+    func["signature"]["params"] = 3;
+    func["regs_num"] = 8;
+    for (size_t i = 0; i < insNum; i++) {
+        func["ins"].append(MakeInstruction(i));
+    }
+    func["labels"] = Json::Value(Json::arrayValue);
+    func["metadata"]["attribute"] = "";
+    func["catchTables"] = Json::Value(Json::arrayValue);
+    func["sourceFile"] = "benchmark.ts";
+
+    Json::Value piece;
+    piece["type"] = 0;
+    piece["func_body"] = func;
+    return Stringify(piece);
+}
+
+static Json::Value MakeLiteral(size_t idx)
+{
+    Json::Value literal;
+    switch (idx % LITERAL_KINDS) {
+        case 0:
+            literal["tag"] = static_cast<Json::UInt>(panda::panda_file::LiteralTag::STRING);
+            literal["value"] = "literal_" + std::to_string(idx);
+            break;
+        case 1:
+            literal["tag"] = static_cast<Json::UInt>(panda::panda_file::LiteralTag::INTEGER);
+            literal["value"] = static_cast<Json::Int>(idx);
+            break;
+        default:
+            literal["tag"] = static_cast<Json::UInt>(panda::panda_file::LiteralTag::DOUBLE);
+            literal["value"] = static_cast<double>(idx) + 0.5;
+            break;
+    }
+    return literal;
+}
+
+static std::string MakeStream()
+{
+    std::string stream;
+    auto append = [&stream](const std::string &piece) {
+        stream += "$" + piece + "$\n";
+    };
+
+    Json::Value options;
+    options["type"] = 4;
+    options["opt_level"] = 0;
+    append(Stringify(options));
+
+    for (size_t i = 0; i < SYNTHETIC_FUNCTIONS; i++) {
+        append(MakeFunctionPiece(i, SYNTHETIC_INSTRUCTIONS));
+    }
+
+    for (size_t i = 0; i < SYNTHETIC_STRINGS; i++) {
+        Json::Value str;
+        str["type"] = 2;
+        str["string"] = "identifier_" + std::to_string(i);
+        append(Stringify(str));
+    }
+
+    const size_t literalsPerArray = 6;
+    for (size_t i = 0; i < SYNTHETIC_LITERAL_ARRAYS; i++) {
+        Json::Value literalArray;
+        literalArray["type"] = 3;
+        for (size_t j = 0; j < literalsPerArray; j++) {
+            literalArray["literalArray"]["literalBuffer"].append(MakeLiteral(j));
+        }
+        append(Stringify(literalArray));
+    }
+
+    return stream;
+}
+
+// a benchmark that stopped doing its work measures nothing, give up on the first failure
+[[noreturn]] static void Fail(const std::string &what)
+{
+    std::cerr << "benchmark failed: " << what << std::endl;
+    std::exit(RETURN_FAILED);
+}
+
+// every parse starts from the state of a fresh process, ParseData keeps the options and the
+// removed functions of a stream in globals
+static void ParseStream(const std::string &name, const std::string &stream, panda::pandasm::Program &prog)
+{
+    ResetParseState();
+    prog.lang = panda::pandasm::extensions::Language::ECMASCRIPT;
+    if (!ParseData(stream, prog)) {
+        Fail("ParseData/" + name);
+    }
+}
+
+static std::string Repeat(const std::string &unit, size_t times)
+{
+    std::string result;
+    for (size_t i = 0; i < times; i++) {
+        result += unit;
+    }
+    return result;
+}
+
+static void RunParseBenchmarks(Runner &runner)
+{
+    const size_t stringRepeat = 16;
+    std::string asciiStr = Repeat("identifier", stringRepeat);
+    std::string nonAsciiStr = Repeat("标识符", stringRepeat);
+    std::string escapedStr = Repeat("\\u0041\\u4e2d", stringRepeat);
+    runner.Run("ParseString/ascii", asciiStr.size(), [&]() { g_sink += ParseString(asciiStr).size(); });
+    runner.Run("ParseString/non-ascii", nonAsciiStr.size(), [&]() { g_sink += ParseString(nonAsciiStr).size(); });
+    runner.Run("ParseString/unicode-escape", escapedStr.size(), [&]() { g_sink += ParseString(escapedStr).size(); });
+
+    Json::Value ins = MakeInstruction(0);
+    runner.Run("ParseInstructionOpCode", 0, [&]() {
+        panda::pandasm::Ins pandaIns;
+        ParseInstructionOpCode(ins, pandaIns);
+        g_sink += static_cast<size_t>(pandaIns.opcode);
+    });
+    Json::Value strIns = MakeInstruction(4);
+    runner.Run("ParseInstruction/lda.str", 0, [&]() { g_sink += ParseInstruction(strIns).ids.size(); });
+    Json::Value movIns = MakeInstruction(2);
+    runner.Run("ParseInstruction/mov.dyn", 0, [&]() { g_sink += ParseInstruction(movIns).regs.size(); });
+
+    for (size_t i = 0; i < LITERAL_KINDS; i++) {
+        Json::Value literal = MakeLiteral(i);
+        std::string name = "ParseLiteral/tag" + std::to_string(literal["tag"].asUInt());
+        runner.Run(name, 0, [&]() {
+            std::vector<panda::pandasm::LiteralArray::Literal> literalArray;
+            ParseLiteral(literal, literalArray);
+            g_sink += literalArray.size();
+        });
+    }
+
+    // the parse alone, as with --disable-peephole
+    SetPeepholeEnabled(false);
+    std::string funcPiece = MakeFunctionPiece(0, SYNTHETIC_INSTRUCTIONS);
+    runner.Run("ParseSmallPieceJson/function", funcPiece.size(), [&]() {
+        panda::pandasm::Program prog;
+        if (ParseSmallPieceJson(funcPiece, prog) != RETURN_SUCCESS) {
+            Fail("ParseSmallPieceJson/function");
+        }
+        g_sink += prog.function_table.size();
+    });
+    SetPeepholeEnabled(true);
+}
+
+static void RunStreamBenchmarks(Runner &runner, const std::string &name, const std::string &stream)
+{
+    runner.Run("ParseData splitting/" + name, stream.size(), [&]() {
+        ForEachPiece(stream, [](const std::string &piece) {
+            g_sink += piece.size();
+            return true;
+        });
+    });
+
+    SetPeepholeEnabled(false);
+    runner.Run("ParseData/" + name, stream.size(), [&]() {
+        panda::pandasm::Program prog;
+        ParseStream(name, stream, prog);
+        g_sink += prog.function_table.size();
+    });
+    SetPeepholeEnabled(true);
+
+    // the program as ts2abc emits it, into memory so that no file system is timed
+    panda::pandasm::Program prog;
+    ParseStream(name, stream, prog);
+    runner.Run("AsmEmitter::Emit/" + name, 0, [&]() {
+        auto pandaFile = panda::pandasm::AsmEmitter::Emit(prog);
+        if (pandaFile == nullptr) {
+            Fail("AsmEmitter::Emit/" + name + ": " + panda::pandasm::AsmEmitter::GetLastError());
+        }
+        g_sink++;
+    });
+}
+} // namespace panda::ts2abc::benchmark
+
+int main(int argc, const char *argv[])
+{
+    using namespace panda::ts2abc::benchmark;
+
+    panda::PandArgParser argParser;
+    panda::PandArg<bool> helpArg("help", false, "Print this message and exit");
+    argParser.Add(&helpArg);
+    panda::PandArg<int> minTimeArg("min-time-ms", 200, "Minimal time spent in every benchmark");
+    argParser.Add(&minTimeArg);
+    panda::PandArg<std::string> filterArg("filter", "", "Only run the benchmarks whose name contains this string");
+    argParser.Add(&filterArg);
+    panda::PandArg<std::string> streamsArg("streams", TS2ABC_BENCHMARK_STREAMS,
+        "Colon separated list of recorded piece streams (e.g. '.pieces' files from incremental builds). "
+        "Default: the corpus of benchmark/streams, recorded by benchmark/record_streams.py");
+    argParser.Add(&streamsArg);
+
+    if (!argParser.Parse(argc, argv) || helpArg.GetValue()) {
+        std::cerr << argParser.GetErrorString();
+        std::cerr << "Usage: js2abc_benchmark [OPTIONS]" << std::endl;
+        std::cerr << argParser.GetHelpString();
+        return helpArg.GetValue() ? panda::ts2abc::RETURN_SUCCESS : panda::ts2abc::RETURN_FAILED;
+    }
+
+    // heap allocations are counted by the operator new of mem_stat.cpp, the benchmark is always
+    // built with TS2ABC_COUNT_ALLOCATIONS
+    static_assert(panda::ts2abc::ALLOCATION_COUNTING_BUILT, "build the benchmark with TS2ABC_COUNT_ALLOCATIONS");
+    panda::ts2abc::EnableAllocationCounting();
+    Runner runner(minTimeArg.GetValue(), filterArg.GetValue());
+    Runner::PrintHeader();
+
+    RunParseBenchmarks(runner);
+    RunStreamBenchmarks(runner, "synthetic", MakeStream());
+
+    std::string streams = streamsArg.GetValue();
+    size_t start = 0;
+    while (start < streams.size()) {
+        size_t end = streams.find(':', start);
+        if (end == std::string::npos) {
+            end = streams.size();
+        }
+        std::string file = streams.substr(start, end - start);
+        start = end + 1;
+        if (file.empty()) {
+            continue;
+        }
+        std::string stream;
+        if (!panda::ts2abc::HandleJsonFile(file, stream)) {
+            Fail("reading " + file);
+        }
+        RunStreamBenchmarks(runner, file.substr(file.find_last_of('/') + 1), stream);
+    }
+
+    return g_sink == 0 ? panda::ts2abc::RETURN_FAILED : panda::ts2abc::RETURN_SUCCESS;
+}
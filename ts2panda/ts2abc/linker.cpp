@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "linker.h"
+#include "sweep.h"
+
+#include <type_traits>
+#include <unordered_set>
+#include <variant>
+
+namespace panda::ts2abc {
+namespace {
+    const std::string ES_MODULE_MODE_RECORD = "_ESModuleMode";
+    const std::string MODULE_NAME_SEPARATOR = "::";
+
+    bool IsMethodLiteral(const panda::pandasm::LiteralArray::Literal &literal)
+    {
+        return (literal.tag_ == panda::panda_file::LiteralTag::METHOD ||
+            literal.tag_ == panda::panda_file::LiteralTag::GENERATORMETHOD) &&
+            std::holds_alternative<std::string>(literal.value_);
+    }
+
+    // Byte-exact content of a literal array, two arrays with the same key are interchangeable
+    std::string LiteralArrayKey(const panda::pandasm::LiteralArray &literalArray)
+    {
+        std::string key;
+        for (const auto &literal : literalArray.literals_) {
+            key += static_cast<char>(literal.tag_);
+            key += static_cast<char>(literal.value_.index());
+            std::visit([&key](const auto &value) {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, std::string>) {
+                    key += std::to_string(value.size()) + ":" + value;
+                } else {
+                    key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+                }
+            }, literal.value_);
+        }
+        return key;
+    }
+}
+
+void ModuleLinker::AddModule(panda::pandasm::Program &module, const std::string &moduleName)
+{
+    bool isEntry = stat_.modules++ == 0;
+    std::unordered_set<std::string> functionNames;
+    for (const auto &[name, func] : module.function_table) {
+        functionNames.insert(name);
+    }
+    auto linkedName = [&](const std::string &name) {
+        if (isEntry || functionNames.find(name) == functionNames.end()) {
+            return name;
+        }
+        return moduleName + MODULE_NAME_SEPARATOR + name;
+    };
+
+    // literal arrays first, the functions need their new ids
+    std::unordered_map<int64_t, int64_t> literalArrayIndexes;
+    stat_.literalArrays += module.literalarray_table.size();
+    for (auto &[id, literalArray] : module.literalarray_table) {
+        for (auto &literal : literalArray.literals_) {
+            if (IsMethodLiteral(literal)) {
+                literal.value_ = linkedName(std::get<std::string>(literal.value_));
+            }
+        }
+
+        auto key = LiteralArrayKey(literalArray);
+        auto iter = literalArrayIds_.find(key);
+        if (iter == literalArrayIds_.end()) {
+            auto linkedId = std::to_string(prog_.literalarray_table.size());
+            iter = literalArrayIds_.emplace(std::move(key), linkedId).first;
+            prog_.literalarray_table.emplace(linkedId, std::move(literalArray));
+        }
+        literalArrayIndexes[std::stoll(id)] = std::stoll(iter->second);
+    }
+
+    for (auto &[name, func] : module.function_table) {
+        for (auto &ins : func.ins) {
+            if (ins.HasFlag(panda::pandasm::InstFlags::METHOD_ID)) {
+                for (auto &id : ins.ids) {
+                    id = linkedName(id);
+                }
+            }
+            if (RefersToLiteralArray(ins)) {
+                auto iter = literalArrayIndexes.find(std::get<int64_t>(ins.imms[0]));
+                if (iter != literalArrayIndexes.end()) {
+                    ins.imms[0] = iter->second;
+                }
+            }
+        }
+        auto funcName = linkedName(name);
+        func.name = funcName;
+        prog_.function_table.emplace(funcName, std::move(func));
+    }
+
+    // the mode record is per file, the caller makes sure that all modules agree on it
+    for (auto &[name, record] : module.record_table) {
+        if (!isEntry && name == ES_MODULE_MODE_RECORD) {
+            continue;
+        }
+        auto recordName = isEntry ? name : moduleName + MODULE_NAME_SEPARATOR + name;
+        record.name = recordName;
+        prog_.record_table.emplace(recordName, std::move(record));
+    }
+
+    stat_.strings += module.strings.size();
+    prog_.strings.insert(module.strings.begin(), module.strings.end());
+}
+} // namespace panda::ts2abc
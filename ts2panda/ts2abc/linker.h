@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PANDA_TS2ABC_LINKER_H_
+#define PANDA_TS2ABC_LINKER_H_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+#include "assembly-program.h"
+
+namespace panda::ts2abc {
+struct LinkStatistics {
+    size_t modules = 0;
+    size_t strings = 0;  // in all modules, before dedup
+    size_t literalArrays = 0;  // in all modules, before dedup
+};
+
+// Merges the programs of several modules into one, so that they are emitted to a single file
+// sharing one string table and one literal array table.
+class ModuleLinker {
+public:
+    explicit ModuleLinker(panda::pandasm::Program &prog) : prog_(prog) {}
+
+    // Moves the content of 'module' into the linked program. The first module is the entry of
+    // the file and keeps its names, the functions and records of the others are prefixed with
+    // "<moduleName>::". Identical literal arrays are stored once and the instructions and
+    // literals referring to them are renumbered.
+    void AddModule(panda::pandasm::Program &module, const std::string &moduleName);
+
+    const LinkStatistics &GetStatistics() const
+    {
+        return stat_;
+    }
+
+private:
+    panda::pandasm::Program &prog_;
+    // content of a literal array -> its id in the linked program
+    std::unordered_map<std::string, std::string> literalArrayIds_;
+    LinkStatistics stat_;
+};
+} // namespace panda::ts2abc
+
+#endif // PANDA_TS2ABC_LINKER_H_
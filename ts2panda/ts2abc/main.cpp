@@ -0,0 +1,182 @@
+/* * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "file_format_version.h"
+#include "ts2abc.h"
+#include "ts2abc_options.h"
+
+int main(int argc, const char *argv[])
+{
+    panda::PandArgParser argParser;
+    panda::Span<const char *> sp(argv, argc);
+    panda::ts2abc::Options options(sp[0]);
+    options.AddOptions(&argParser);
+
+    panda::PandArg<bool> sizeStatArg("size-stat", false, "Print panda file size statistic");
+    argParser.Add(&sizeStatArg);
+    panda::PandArg<bool> helpArg("help", false, "Print this message and exit");
+    argParser.Add(&helpArg);
+    panda::PandArg<int> optLevelArg("opt-level", 0,
+        "Optimization level. Possible values: [0, 1, 2]. Default: 0\n    0: no optimizations\n    "
+        "1: basic bytecode optimizations, including valueNumber, lowering, constantResolver, regAccAllocator\n    "
+        "2: (experimental optimizations): Sta/Lda Peephole, Movi/Lda Peephole, Register Coalescing");
+    argParser.Add(&optLevelArg);
+    panda::PandArg<std::string> optLogLevelArg("opt-log-level", "error",
+        "Optimization log level. Possible values: ['error', 'debug', 'info', 'fatal']. Default: 'error' ");
+    argParser.Add(&optLogLevelArg);
+    panda::PandArg<bool> bcVersionArg("bc-version", false, "Print ark bytecode version");
+    argParser.Add(&bcVersionArg);
+    panda::PandArg<bool> bcMinVersionArg("bc-min-version", false, "Print ark bytecode minimum supported version");
+    argParser.Add(&bcMinVersionArg);
+    panda::PandArg<bool> compileByPipeArg("compile-by-pipe", false, "Compile a json file that is passed by pipe");
+    argParser.Add(&compileByPipeArg);
+    panda::PandArg<std::string> shmFileArg("shm-file", "",
+        "With 'compile-by-pipe', read the json data from this shared memory file once the pipe is closed");
+    argParser.Add(&shmFileArg);
+    panda::PandArg<std::string> incrementalCacheArg("incremental-cache", "",
+        "Cache of the last piece stream. Functions the frontend did not resend are reused from it, "
+        "and it is updated after a successful build");
+    argParser.Add(&incrementalCacheArg);
+    panda::PandArg<bool> disablePeepholeArg("disable-peephole", false,
+        "Disable the built-in peephole pass which removes redundant lda/sta/mov instructions");
+    argParser.Add(&disablePeepholeArg);
+    panda::PandArg<std::string> timingFileArg("timing-file", "",
+        "Write the time spent in each compilation phase to this file, as chrome trace events. What a phase "
+        "counted, such as the entries removed by the sweep, goes into the args of its event");
+    argParser.Add(&timingFileArg);
+    panda::PandArg<std::string> linkArg("link", "",
+        "Link the piece streams listed in this file, one '<module name>\\t<piece file>' per line, into a single "
+        "output. The piece files are the incremental caches of the modules");
+    argParser.Add(&linkArg);
+    panda::PandArg<std::string> splitDebugInfoArg("split-debug-info", "",
+        "Write local variables, source code and columns into this directory instead of the output, "
+        "in a file named after the checksum of the output. A release build keeps optimizing as usual");
+    argParser.Add(&splitDebugInfoArg);
+    panda::PandArg<bool> memStatArg("mem-stat", false,
+        "Print the peak RSS, allocation count and allocated bytes of each phase and the functions holding "
+        "the most memory. Allocations are counted in builds with TS2ABC_COUNT_ALLOCATIONS only");
+    argParser.Add(&memStatArg);
+
+    argParser.EnableTail();
+
+    panda::PandArg<std::string> tailArg1("ARG_1", "", "Path to input(json file) or path to output(ark bytecode)" \
+        " when 'compile-by-pipe' enabled");
+    panda::PandArg<std::string> tailArg2("ARG_2", "", "Path to output(ark bytecode) or ignore when 'compile-by-pipe'" \
+        " enabled");
+    argParser.PushBackTail(&tailArg1);
+    argParser.PushBackTail(&tailArg2);
+
+    if (!argParser.Parse(argc, argv)) {
+        std::cerr << argParser.GetErrorString();
+        std::cerr << argParser.GetHelpString();
+        return panda::ts2abc::RETURN_FAILED;
+    }
+
+    std::string usage = "Usage: ts2abc [OPTIONS]... [ARGS]...";
+    if (helpArg.GetValue()) {
+        std::cout << usage << std::endl;
+        std::cout << argParser.GetHelpString();
+        return panda::ts2abc::RETURN_SUCCESS;
+    }
+
+    if (bcVersionArg.GetValue() || bcMinVersionArg.GetValue()) {
+        std::string version = bcVersionArg.GetValue() ? panda::panda_file::GetVersion(panda::panda_file::version) :
+            panda::panda_file::GetVersion(panda::panda_file::minVersion);
+        std::cout << version << std::endl;
+        return panda::ts2abc::RETURN_SUCCESS;
+    }
+
+    if ((optLevelArg.GetValue() < O_LEVEL0) || (optLevelArg.GetValue() > O_LEVEL2)) {
+        std::cerr << "Incorrect optimization level value" << std::endl;
+        std::cerr << usage << std::endl;
+        std::cerr << argParser.GetHelpString();
+        return panda::ts2abc::RETURN_FAILED;
+    }
+
+    panda::ts2abc::SetPeepholeEnabled(!disablePeepholeArg.GetValue());
+    if (!timingFileArg.GetValue().empty()) {
+        panda::ts2abc::EnableTiming();
+    }
+    panda::ts2abc::SetSplitDebugInfo(splitDebugInfoArg.GetValue());
+    if (memStatArg.GetValue()) {
+        panda::ts2abc::EnableMemStat();
+    }
+
+    std::string input, output;
+    std::string data = "";
+
+    if (!linkArg.GetValue().empty()) {
+        output = tailArg1.GetValue();
+        if (output.empty()) {
+            std::cerr << usage << std::endl;
+            std::cerr << argParser.GetHelpString();
+            return panda::ts2abc::RETURN_FAILED;
+        }
+        if (!panda::ts2abc::LinkProgram(linkArg.GetValue(), output, optLevelArg, optLogLevelArg)) {
+            std::cerr << "call LinkProgram fail" << std::endl;
+            return panda::ts2abc::RETURN_FAILED;
+        }
+        if (!timingFileArg.GetValue().empty() && !panda::ts2abc::WriteTimingFile(timingFileArg.GetValue())) {
+            return panda::ts2abc::RETURN_FAILED;
+        }
+        panda::ts2abc::PrintMemStat();
+        return panda::ts2abc::RETURN_SUCCESS;
+    }
+
+    if (!compileByPipeArg.GetValue()) {
+        input = tailArg1.GetValue();
+        output = tailArg2.GetValue();
+        if (input.empty() || output.empty()) {
+            std::cerr << "Incorrect args number" << std::endl;
+            std::cerr << "Usage example: ts2abc test.json test.abc\n" << std::endl;
+            std::cerr << usage << std::endl;
+            std::cerr << argParser.GetHelpString();
+            return panda::ts2abc::RETURN_FAILED;
+        }
+        panda::ts2abc::ScopedTiming timing("read input");
+        if (!panda::ts2abc::HandleJsonFile(input, data)) {
+            return panda::ts2abc::RETURN_FAILED;
+        }
+    } else {
+        output = tailArg1.GetValue();
+        if (output.empty()) {
+            std::cerr << usage << std::endl;
+            std::cerr << argParser.GetHelpString();
+            return panda::ts2abc::RETURN_FAILED;
+        }
+        panda::ts2abc::ScopedTiming timing("read input");
+        if (!shmFileArg.GetValue().empty()) {
+            if (!panda::ts2abc::ReadFromSharedFile(shmFileArg.GetValue(), data)) {
+                return panda::ts2abc::RETURN_FAILED;
+            }
+        } else if (!panda::ts2abc::ReadFromPipe(data)) {
+            return panda::ts2abc::RETURN_FAILED;
+        }
+    }
+
+    if (!panda::ts2abc::GenerateProgram(data, output, optLevelArg, optLogLevelArg, incrementalCacheArg.GetValue())) {
+        std::cerr << "call GenerateProgram fail" << std::endl;
+        return panda::ts2abc::RETURN_FAILED;
+    }
+
+    if (!timingFileArg.GetValue().empty() && !panda::ts2abc::WriteTimingFile(timingFileArg.GetValue())) {
+        return panda::ts2abc::RETURN_FAILED;
+    }
+
+    panda::ts2abc::PrintMemStat();
+    return panda::ts2abc::RETURN_SUCCESS;
+}
@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mem_stat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef PANDA_TARGET_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+    std::atomic<bool> g_countAllocations {false};
+    std::atomic<size_t> g_allocCount {0};
+    std::atomic<size_t> g_allocBytes {0};
+}
+
+#ifdef TS2ABC_COUNT_ALLOCATIONS
+namespace {
+    void *CountedAlloc(std::size_t size) noexcept
+    {
+        if (g_countAllocations.load(std::memory_order_relaxed)) {
+            g_allocCount.fetch_add(1, std::memory_order_relaxed);
+            g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    // like the standard operator new, retries as long as there is a new handler to free memory
+    void *CountedNew(std::size_t size)
+    {
+        void *ptr = nullptr;
+        while ((ptr = CountedAlloc(size)) == nullptr) {
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+        return ptr;
+    }
+
+    // The block is over-allocated to the alignment, the malloc'ed address is kept right
+    // before the aligned one for the delete
+    void *CountedAlignedNew(std::size_t size, std::align_val_t align)
+    {
+        auto alignment = static_cast<std::size_t>(align);
+        if (alignment < sizeof(void *)) {
+            alignment = sizeof(void *);
+        }
+        void *base = CountedNew(size + alignment + sizeof(void *));
+        auto address = reinterpret_cast<std::uintptr_t>(base) + sizeof(void *);
+        address = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+        void *ptr = reinterpret_cast<void *>(address);
+        static_cast<void **>(ptr)[-1] = base;
+        return ptr;
+    }
+
+    void AlignedFree(void *ptr) noexcept
+    {
+        if (ptr != nullptr) {
+            std::free(static_cast<void **>(ptr)[-1]);
+        }
+    }
+}
+
+// The counting allocator hook, only in builds with TS2ABC_COUNT_ALLOCATIONS. It costs one
+// relaxed load per allocation when counting is off
+void *operator new(std::size_t size)
+{
+    return CountedNew(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return CountedNew(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try {
+        return CountedNew(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    try {
+        return CountedNew(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    return CountedAlignedNew(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align)
+{
+    return CountedAlignedNew(size, align);
+}
+
+void *operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    try {
+        return CountedAlignedNew(size, align);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    try {
+        return CountedAlignedNew(size, align);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    AlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    AlignedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    AlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    AlignedFree(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    AlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    AlignedFree(ptr);
+}
+#endif
+
+namespace panda::ts2abc {
+namespace {
+    constexpr size_t TOP_FUNCTIONS_NUM = 10;
+    constexpr size_t BYTES_PER_KB = 1024;
+    constexpr int NAME_WIDTH = 28;
+    constexpr int NUMBER_WIDTH = 16;
+
+    struct PhaseMemory {
+        std::string phase;
+        size_t peakRss = 0;  // bytes, the high water mark of the process when the phase ended
+        size_t peakRise = 0;  // bytes the phase raised the high water mark by
+        size_t allocCount = 0;
+        size_t allocBytes = 0;
+    };
+
+    bool g_memStatEnabled = false;
+    std::vector<PhaseMemory> g_phases;
+    std::vector<std::pair<std::string, size_t>> g_functionMemory;
+
+    size_t GetPeakRss()
+    {
+#ifdef PANDA_TARGET_UNIX
+        struct rusage usage {};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+#ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * BYTES_PER_KB;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    // heap held by a string beyond the object itself, assuming the usual small string buffer
+    size_t StringHeap(const std::string &str)
+    {
+        constexpr size_t SMALL_STRING_CAPACITY = 15;
+        return str.capacity() > SMALL_STRING_CAPACITY ? str.capacity() + 1 : 0;
+    }
+
+    size_t FunctionMemory(const panda::pandasm::Function &func)
+    {
+        size_t size = sizeof(func) + StringHeap(func.name) + StringHeap(func.source_file) +
+            StringHeap(func.source_code);
+        size += func.ins.capacity() * sizeof(panda::pandasm::Ins);
+        for (const auto &ins : func.ins) {
+            size += ins.regs.capacity() * sizeof(ins.regs[0]);
+            size += ins.ids.capacity() * sizeof(std::string);
+            for (const auto &id : ins.ids) {
+                size += StringHeap(id);
+            }
+            size += ins.imms.capacity() * sizeof(ins.imms[0]);
+            size += StringHeap(ins.label) + StringHeap(ins.ins_debug.whole_line);
+        }
+        for (const auto &[name, label] : func.label_table) {
+            size += sizeof(name) + sizeof(label) + StringHeap(name);
+        }
+        size += func.catch_blocks.capacity() * sizeof(panda::pandasm::Function::CatchBlock);
+        for (const auto &variable : func.local_variable_debug) {
+            size += sizeof(variable) + StringHeap(variable.name) + StringHeap(variable.signature) +
+                StringHeap(variable.signature_type);
+        }
+        return size;
+    }
+
+    PhaseMemory &GetPhase(const char *phase)
+    {
+        auto iter = std::find_if(g_phases.begin(), g_phases.end(), [phase](const PhaseMemory &phaseMemory) {
+            return phaseMemory.phase == phase;
+        });
+        if (iter != g_phases.end()) {
+            return *iter;
+        }
+        g_phases.push_back({phase});
+        return g_phases.back();
+    }
+}
+
+void EnableMemStat()
+{
+    g_memStatEnabled = true;
+    EnableAllocationCounting();
+}
+
+void EnableAllocationCounting()
+{
+    g_countAllocations = true;
+}
+
+size_t GetAllocationCount()
+{
+    return g_allocCount.load(std::memory_order_relaxed);
+}
+
+size_t GetAllocatedBytes()
+{
+    return g_allocBytes.load(std::memory_order_relaxed);
+}
+
+bool IsMemStatEnabled()
+{
+    return g_memStatEnabled;
+}
+
+ScopedMemStat::ScopedMemStat(const char *phase) : phase_(phase)
+{
+    if (IsMemStatEnabled()) {
+        peakRss_ = GetPeakRss();
+        allocCount_ = g_allocCount.load(std::memory_order_relaxed);
+        allocBytes_ = g_allocBytes.load(std::memory_order_relaxed);
+    }
+}
+
+ScopedMemStat::~ScopedMemStat()
+{
+    if (!IsMemStatEnabled()) {
+        return;
+    }
+
+    size_t allocCount = g_allocCount.load(std::memory_order_relaxed) - allocCount_;
+    size_t allocBytes = g_allocBytes.load(std::memory_order_relaxed) - allocBytes_;
+    // the bookkeeping below allocates too, keep it out of the counts
+    g_countAllocations = false;
+    auto &phaseMemory = GetPhase(phase_);
+    size_t peakRss = GetPeakRss();
+    phaseMemory.peakRss = std::max(phaseMemory.peakRss, peakRss);
+    phaseMemory.peakRise += peakRss - peakRss_;
+    phaseMemory.allocCount += allocCount;
+    phaseMemory.allocBytes += allocBytes;
+    g_countAllocations = true;
+}
+
+void RecordFunctionMemory(const panda::pandasm::Program &prog)
+{
+    if (!IsMemStatEnabled()) {
+        return;
+    }
+
+    g_countAllocations = false;
+    g_functionMemory.clear();
+    for (const auto &[name, func] : prog.function_table) {
+        g_functionMemory.emplace_back(name, FunctionMemory(func));
+    }
+    std::sort(g_functionMemory.begin(), g_functionMemory.end(), [](const auto &a, const auto &b) {
+        return a.second > b.second;
+    });
+    if (g_functionMemory.size() > TOP_FUNCTIONS_NUM) {
+        g_functionMemory.resize(TOP_FUNCTIONS_NUM);
+    }
+    g_countAllocations = true;
+}
+
+void PrintMemStat()
+{
+    if (!IsMemStatEnabled()) {
+        return;
+    }
+
+    g_countAllocations = false;
+    std::cout << "ts2abc memory statistics (nested phases are also counted in the enclosing ones)" << std::endl;
+    std::cout << "peak rss is the high water mark of the process so far, peak rise what the phase added to it" <<
+        std::endl;
+    if (!ALLOCATION_COUNTING_BUILT) {
+        std::cout << "allocations are not counted, build ts2abc with TS2ABC_COUNT_ALLOCATIONS for them" << std::endl;
+    }
+    std::cout << std::left << std::setw(NAME_WIDTH) << "phase" << std::right << std::setw(NUMBER_WIDTH) <<
+        "peak rss(KB)" << std::setw(NUMBER_WIDTH) << "peak rise(KB)" << std::setw(NUMBER_WIDTH) << "allocations" <<
+        std::setw(NUMBER_WIDTH) << "allocated(KB)" << std::endl;
+    for (const auto &phaseMemory : g_phases) {
+        std::cout << std::left << std::setw(NAME_WIDTH) << phaseMemory.phase << std::right <<
+            std::setw(NUMBER_WIDTH) << phaseMemory.peakRss / BYTES_PER_KB << std::setw(NUMBER_WIDTH) <<
+            phaseMemory.peakRise / BYTES_PER_KB << std::setw(NUMBER_WIDTH) << phaseMemory.allocCount <<
+            std::setw(NUMBER_WIDTH) << phaseMemory.allocBytes / BYTES_PER_KB << std::endl;
+    }
+    std::cout << std::left << std::setw(NAME_WIDTH) << "total" << std::right << std::setw(NUMBER_WIDTH) <<
+        GetPeakRss() / BYTES_PER_KB << std::setw(NUMBER_WIDTH) << "" << std::setw(NUMBER_WIDTH) <<
+        g_allocCount.load() << std::setw(NUMBER_WIDTH) << g_allocBytes.load() / BYTES_PER_KB << std::endl;
+
+    if (g_functionMemory.empty()) {
+        return;
+    }
+    std::cout << "top " << g_functionMemory.size() << " functions by memory held in the program" << std::endl;
+    for (const auto &[name, size] : g_functionMemory) {
+        std::cout << std::left << std::setw(NAME_WIDTH) << name << std::right << std::setw(NUMBER_WIDTH) <<
+            size << " bytes" << std::endl;
+    }
+}
+} // namespace panda::ts2abc
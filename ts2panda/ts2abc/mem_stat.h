@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PANDA_TS2ABC_MEM_STAT_H_
+#define PANDA_TS2ABC_MEM_STAT_H_
+
+#include <cstddef>
+
+#include "assembly-program.h"
+
+namespace panda::ts2abc {
+// Memory accounting for --mem-stat. In builds with TS2ABC_COUNT_ALLOCATIONS every allocation through
+// operator new is counted while it is enabled, the counts are attributed to the ScopedMemStat phases
+// that are open. Other builds keep the standard operator new and report the rss only.
+#ifdef TS2ABC_COUNT_ALLOCATIONS
+constexpr bool ALLOCATION_COUNTING_BUILT = true;
+#else
+constexpr bool ALLOCATION_COUNTING_BUILT = false;
+#endif
+
+void EnableMemStat();
+bool IsMemStatEnabled();
+
+// Counting alone, without the phase report. The benchmarks read the counters around each run
+void EnableAllocationCounting();
+size_t GetAllocationCount();
+size_t GetAllocatedBytes();
+
+class ScopedMemStat {
+public:
+    explicit ScopedMemStat(const char *phase);
+    ~ScopedMemStat();
+    ScopedMemStat(const ScopedMemStat &) = delete;
+    ScopedMemStat &operator=(const ScopedMemStat &) = delete;
+
+private:
+    const char *phase_;
+    size_t peakRss_ = 0;
+    size_t allocCount_ = 0;
+    size_t allocBytes_ = 0;
+};
+
+// Estimates what each function of 'prog' holds, for the top functions of the report
+void RecordFunctionMemory(const panda::pandasm::Program &prog);
+// Per phase: the peak RSS so far at its end and how much the phase raised it, allocations and
+// allocated bytes, then the top functions
+void PrintMemStat();
+} // namespace panda::ts2abc
+
+#endif // PANDA_TS2ABC_MEM_STAT_H_
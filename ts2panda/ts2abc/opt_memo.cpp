@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "opt_memo.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <variant>
+
+namespace panda::ts2abc {
+namespace {
+    using Opcode = panda::pandasm::Opcode;
+
+    // Everything of a function's body the optimizer looks at, with the labels renamed in order
+    // of appearance. Names, debug info and metadata are left out.
+    std::string NormalizedBody(const panda::pandasm::Function &func)
+    {
+        std::unordered_map<std::string, size_t> labels;
+        auto label = [&labels](const std::string &name) {
+            auto iter = labels.emplace(name, labels.size()).first;
+            return "L" + std::to_string(iter->second);
+        };
+
+        std::string body = std::to_string(func.regs_num) + " " + std::to_string(func.params.size()) + "\n";
+        for (const auto &ins : func.ins) {
+            body += std::to_string(static_cast<int>(ins.opcode));
+            if (ins.set_label) {
+                body += " @" + label(ins.label);
+            }
+            for (auto reg : ins.regs) {
+                body += " v" + std::to_string(reg);
+            }
+            for (const auto &id : ins.ids) {
+                // jumps refer to their target by id
+                body += " " + (ins.HasFlag(panda::pandasm::InstFlags::JUMP) ? label(id) : std::to_string(id.size()) + ":" + id);
+            }
+            for (const auto &imm : ins.imms) {
+                body += std::visit([](auto value) {
+                    using T = std::decay_t<decltype(value)>;
+                    std::string bits(reinterpret_cast<const char *>(&value), sizeof(value));
+                    return std::string(std::is_same_v<T, double> ? " d" : " i") + bits;
+                }, imm);
+            }
+            body += "\n";
+        }
+        for (const auto &catchBlock : func.catch_blocks) {
+            body += "catch " + catchBlock.exception_record + " " + label(catchBlock.try_begin_label) + " " +
+                label(catchBlock.try_end_label) + " " + label(catchBlock.catch_begin_label) + " " +
+                label(catchBlock.catch_end_label) + "\n";
+        }
+        return body;
+    }
+
+    // Line numbers of 'duplicate' in terms of those of 'representative', false if one line of the
+    // representative is on several lines in the duplicate
+    bool MapLines(const panda::pandasm::Function &representative, const panda::pandasm::Function &duplicate,
+                  std::unordered_map<size_t, size_t> &lines)
+    {
+        for (size_t i = 0; i < representative.ins.size(); i++) {
+            auto from = representative.ins[i].ins_debug.line_number;
+            auto to = duplicate.ins[i].ins_debug.line_number;
+            auto iter = lines.emplace(from, to).first;
+            if (iter->second != to) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void MakeStub(panda::pandasm::Function &func)
+    {
+        panda::pandasm::Ins ret;
+        ret.opcode = Opcode::RETURN_DYN;
+        func.ins.clear();
+        func.ins.push_back(ret);
+        func.label_table.clear();
+        func.catch_blocks.clear();
+        func.regs_num = 0;
+    }
+}
+
+void OptimizationMemo::SetAside(panda::pandasm::Program &prog)
+{
+    // the function table is unordered, the lowest name of a body represents it so that
+    // the output does not depend on the hashing
+    std::vector<std::string> names;
+    names.reserve(prog.function_table.size());
+    for (const auto &entry : prog.function_table) {
+        names.push_back(entry.first);
+    }
+    std::sort(names.begin(), names.end());
+
+    std::unordered_map<std::string, std::string> representatives;
+    for (const auto &name : names) {
+        auto &func = prog.function_table.at(name);
+        auto body = NormalizedBody(func);
+        auto iter = representatives.find(body);
+        if (iter == representatives.end()) {
+            representatives.emplace(std::move(body), name);
+            continue;
+        }
+
+        // the ranges of local variables index the instructions, which the optimizer moves
+        // in the representative only
+        if (!func.local_variable_debug.empty()) {
+            continue;
+        }
+
+        Duplicate duplicate {name, iter->second, {}};
+        if (!MapLines(prog.function_table.at(iter->second), func, duplicate.lines)) {
+            continue;
+        }
+        MakeStub(func);
+        duplicates_.push_back(std::move(duplicate));
+    }
+}
+
+void OptimizationMemo::Restore(panda::pandasm::Program &prog)
+{
+    for (const auto &duplicate : duplicates_) {
+        const auto &representative = prog.function_table.at(duplicate.representative);
+        auto &func = prog.function_table.at(duplicate.name);
+        func.ins = representative.ins;
+        func.label_table = representative.label_table;
+        func.catch_blocks = representative.catch_blocks;
+        func.regs_num = representative.regs_num;
+        for (auto &ins : func.ins) {
+            auto iter = duplicate.lines.find(ins.ins_debug.line_number);
+            if (iter != duplicate.lines.end()) {
+                ins.ins_debug.line_number = iter->second;
+            }
+        }
+    }
+}
+} // namespace panda::ts2abc
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PANDA_TS2ABC_OPT_MEMO_H_
+#define PANDA_TS2ABC_OPT_MEMO_H_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "assembly-program.h"
+
+namespace panda::ts2abc {
+// Lets the optimizer see each distinct function body once. Generated code such as field
+// initializers, accessors and helpers is often identical apart from the function name.
+class OptimizationMemo {
+public:
+    // Replaces the body of every function identical to one with a lower name by a stub, so
+    // that the optimizer has next to nothing to do for it. Functions with local variable
+    // debug info are left alone.
+    void SetAside(panda::pandasm::Program &prog);
+
+    // Gives the set aside functions a copy of the optimized body of their representative,
+    // with their own line numbers
+    void Restore(panda::pandasm::Program &prog);
+
+    // optimizer invocations on a full body saved
+    size_t GetSavedCount() const
+    {
+        return duplicates_.size();
+    }
+
+private:
+    struct Duplicate {
+        std::string name;
+        std::string representative;
+        // line number in the representative -> line number in the duplicate
+        std::unordered_map<size_t, size_t> lines;
+    };
+
+    std::vector<Duplicate> duplicates_;
+};
+} // namespace panda::ts2abc
+
+#endif // PANDA_TS2ABC_OPT_MEMO_H_
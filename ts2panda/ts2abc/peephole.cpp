@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "peephole.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace panda::ts2abc {
+namespace {
+    using Opcode = panda::pandasm::Opcode;
+
+    bool HasReg(const panda::pandasm::Ins &ins, size_t idx)
+    {
+        return ins.regs.size() > idx;
+    }
+
+    bool SameReg(const panda::pandasm::Ins &a, const panda::pandasm::Ins &b)
+    {
+        return HasReg(a, 0) && HasReg(b, 0) && a.regs[0] == b.regs[0];
+    }
+
+    // Instructions which only overwrite the accumulator and have no other side effect
+    bool IsPureAccLoad(const panda::pandasm::Ins &ins)
+    {
+        switch (ins.opcode) {
+            case Opcode::LDA_DYN:
+            case Opcode::LDAI_DYN:
+            case Opcode::FLDAI_DYN:
+            case Opcode::LDA_STR:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool IsSelfMove(const panda::pandasm::Ins &ins)
+    {
+        return ins.opcode == Opcode::MOV_DYN && HasReg(ins, 1) && ins.regs[0] == ins.regs[1];
+    }
+
+    // Is 'cur' a no-op given that 'prev' has just been executed?
+    bool IsRedundantAfter(const panda::pandasm::Ins &prev, const panda::pandasm::Ins &cur)
+    {
+        if (prev.opcode == Opcode::STA_DYN) {
+            // sta vX; lda vX  -> acc already holds vX
+            // sta vX; sta vX  -> vX already holds acc
+            return (cur.opcode == Opcode::LDA_DYN || cur.opcode == Opcode::STA_DYN) && SameReg(prev, cur);
+        }
+
+        if (prev.opcode == Opcode::LDA_DYN) {
+            // lda vX; sta vX  -> vX already holds acc
+            return cur.opcode == Opcode::STA_DYN && SameReg(prev, cur);
+        }
+
+        if (prev.opcode == Opcode::MOV_DYN && cur.opcode == Opcode::MOV_DYN && HasReg(prev, 1) && HasReg(cur, 1)) {
+            // mov vA, vB; mov vA, vB  or  mov vA, vB; mov vB, vA
+            return (prev.regs[0] == cur.regs[0] && prev.regs[1] == cur.regs[1]) ||
+                (prev.regs[0] == cur.regs[1] && prev.regs[1] == cur.regs[0]);
+        }
+
+        return false;
+    }
+
+    // local variable ranges are instruction indexes, move them onto the instructions that are kept.
+    // 'origins' holds the original index of every kept instruction, in order
+    void RemapLocalVariables(panda::pandasm::Function &func, const std::vector<size_t> &origins)
+    {
+        auto newIndex = [&origins](size_t idx) {
+            return static_cast<size_t>(std::lower_bound(origins.begin(), origins.end(), idx) - origins.begin());
+        };
+        for (auto &variable : func.local_variable_debug) {
+            size_t start = newIndex(variable.start);
+            size_t end = newIndex(variable.start + variable.length);
+            variable.start = static_cast<uint32_t>(start);
+            variable.length = static_cast<uint32_t>(end - start);
+        }
+    }
+}
+
+size_t RunPeephole(panda::pandasm::Function &func)
+{
+    auto &insns = func.ins;
+    std::vector<panda::pandasm::Ins> result;
+    result.reserve(insns.size());
+    std::vector<size_t> origins;
+    origins.reserve(insns.size());
+
+    for (size_t idx = 0; idx < insns.size(); idx++) {
+        auto &ins = insns[idx];
+        // a labeled instruction may be reached from elsewhere, so nothing before it can be assumed
+        if (ins.set_label) {
+            result.push_back(std::move(ins));
+            origins.push_back(idx);
+            continue;
+        }
+
+        if (IsSelfMove(ins)) {
+            continue;
+        }
+
+        if (!result.empty() && IsRedundantAfter(result.back(), ins)) {
+            continue;
+        }
+
+        // lda vX; lda vY  -> the first load is dead
+        while (!result.empty() && IsPureAccLoad(ins) && IsPureAccLoad(result.back()) && !result.back().set_label) {
+            result.pop_back();
+            origins.pop_back();
+        }
+
+        result.push_back(std::move(ins));
+        origins.push_back(idx);
+    }
+
+    size_t removed = insns.size() - result.size();
+    insns = std::move(result);
+    if (removed != 0) {
+        RemapLocalVariables(func, origins);
+    }
+    return removed;
+}
+} // namespace panda::ts2abc
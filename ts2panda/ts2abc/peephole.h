@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PANDA_TS2ABC_PEEPHOLE_H_
+#define PANDA_TS2ABC_PEEPHOLE_H_
+
+#include <cstddef>
+
+#include "assembly-function.h"
+
+namespace panda::ts2abc {
+// Cheap single-pass cleanup of the instruction stream produced by the frontend.
+// It never looks across a label, so jump targets and catch-block boundaries are
+// preserved, and local variable ranges are moved onto the kept instructions.
+// Returns the number of removed instructions.
+size_t RunPeephole(panda::pandasm::Function &func);
+} // namespace panda::ts2abc
+
+#endif // PANDA_TS2ABC_PEEPHOLE_H_
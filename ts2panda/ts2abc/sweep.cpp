@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sweep.h"
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+
+namespace panda::ts2abc {
+namespace {
+    using Opcode = panda::pandasm::Opcode;
+
+    // size of an entry in the panda file, the uleb128 headers are counted as one byte
+    constexpr size_t STRING_HEADER_SIZE = 2;  // utf16 length and the terminating zero
+    constexpr size_t LITERAL_ARRAY_HEADER_SIZE = 4;  // number of literals
+    constexpr size_t LITERAL_TAG_SIZE = 1;
+    constexpr size_t OFFSET_SIZE = 4;
+
+    size_t LiteralArraySize(const panda::pandasm::LiteralArray &literalArray)
+    {
+        size_t size = LITERAL_ARRAY_HEADER_SIZE;
+        for (const auto &literal : literalArray.literals_) {
+            size += LITERAL_TAG_SIZE;
+            size += std::visit([](const auto &value) {
+                using T = std::decay_t<decltype(value)>;
+                // strings and methods are stored as offsets
+                if constexpr (std::is_same_v<T, std::string>) {
+                    return OFFSET_SIZE;
+                } else {
+                    return sizeof(value);
+                }
+            }, literal.value_);
+        }
+        return size;
+    }
+
+    void SweepStrings(panda::pandasm::Program &prog, SweepStatistics &stat)
+    {
+        // every id may name a string, only those that certainly do not are left out
+        std::unordered_set<std::string> used;
+        for (const auto &[name, func] : prog.function_table) {
+            for (const auto &ins : func.ins) {
+                used.insert(ins.ids.begin(), ins.ids.end());
+            }
+        }
+        for (const auto &[id, literalArray] : prog.literalarray_table) {
+            for (const auto &literal : literalArray.literals_) {
+                if (std::holds_alternative<std::string>(literal.value_)) {
+                    used.insert(std::get<std::string>(literal.value_));
+                }
+            }
+        }
+
+        for (auto iter = prog.strings.begin(); iter != prog.strings.end();) {
+            if (used.find(*iter) != used.end()) {
+                ++iter;
+                continue;
+            }
+            stat.strings++;
+            stat.bytes += iter->size() + STRING_HEADER_SIZE;
+            iter = prog.strings.erase(iter);
+        }
+    }
+
+    void SweepLiteralArrays(panda::pandasm::Program &prog, SweepStatistics &stat)
+    {
+        std::unordered_set<int64_t> used;
+        for (const auto &[name, func] : prog.function_table) {
+            for (const auto &ins : func.ins) {
+                if (RefersToLiteralArray(ins)) {
+                    used.insert(std::get<int64_t>(ins.imms[0]));
+                }
+            }
+        }
+
+        // keep the order of the frontend, the ids are the indexes the instructions use
+        std::map<int64_t, std::string> ids;
+        for (const auto &[id, literalArray] : prog.literalarray_table) {
+            if (id.empty() || id.find_first_not_of("0123456789") != std::string::npos) {
+                return;
+            }
+            ids.emplace(std::stoll(id), id);
+        }
+
+        decltype(prog.literalarray_table) literalArrays;
+        std::unordered_map<int64_t, int64_t> indexes;
+        for (const auto &[index, id] : ids) {
+            auto &literalArray = prog.literalarray_table.at(id);
+            if (used.find(index) == used.end()) {
+                stat.literalArrays++;
+                stat.bytes += LiteralArraySize(literalArray);
+                continue;
+            }
+            auto newIndex = static_cast<int64_t>(literalArrays.size());
+            indexes.emplace(index, newIndex);
+            literalArrays.emplace(std::to_string(newIndex), std::move(literalArray));
+        }
+        if (stat.literalArrays == 0) {
+            return;
+        }
+
+        prog.literalarray_table = std::move(literalArrays);
+        for (auto &[name, func] : prog.function_table) {
+            for (auto &ins : func.ins) {
+                if (!RefersToLiteralArray(ins)) {
+                    continue;
+                }
+                auto iter = indexes.find(std::get<int64_t>(ins.imms[0]));
+                if (iter != indexes.end()) {
+                    ins.imms[0] = iter->second;
+                }
+            }
+        }
+    }
+}
+
+bool RefersToLiteralArray(const panda::pandasm::Ins &ins)
+{
+    switch (ins.opcode) {
+        case Opcode::ECMA_CREATEARRAYWITHBUFFER:
+        case Opcode::ECMA_CREATEOBJECTWITHBUFFER:
+        case Opcode::ECMA_CREATEOBJECTHAVINGMETHOD:
+        case Opcode::ECMA_DEFINECLASSWITHBUFFER:
+            return !ins.imms.empty() && std::holds_alternative<int64_t>(ins.imms[0]);
+        default:
+            return false;
+    }
+}
+
+SweepStatistics SweepDeadEntries(panda::pandasm::Program &prog)
+{
+    SweepStatistics stat;
+    // literal arrays first, the strings of the dropped ones may die with them
+    SweepLiteralArrays(prog, stat);
+    SweepStrings(prog, stat);
+    return stat;
+}
+} // namespace panda::ts2abc
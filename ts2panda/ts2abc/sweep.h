@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PANDA_TS2ABC_SWEEP_H_
+#define PANDA_TS2ABC_SWEEP_H_
+
+#include <cstddef>
+
+#include "assembly-program.h"
+
+namespace panda::ts2abc {
+struct SweepStatistics {
+    size_t strings = 0;
+    size_t literalArrays = 0;
+    size_t bytes = 0;  // estimated size of the removed entries in the panda file
+};
+
+// Instructions whose first immediate is the index of a literal array
+bool RefersToLiteralArray(const panda::pandasm::Ins &ins);
+
+// Drops the strings and literal arrays no instruction refers to anymore, typically after the
+// optimizer removed their last use. Literal arrays are referred to by index, the remaining ones
+// are renumbered and so are the instructions.
+SweepStatistics SweepDeadEntries(panda::pandasm::Program &prog);
+} // namespace panda::ts2abc
+
+#endif // PANDA_TS2ABC_SWEEP_H_
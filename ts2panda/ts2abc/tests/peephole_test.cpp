@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests of the peephole pass of ts2abc. Every case is a short instruction stream
+// and the opcodes and registers which must be left of it.
+
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "assembly-function.h"
+#include "peephole.h"
+
+namespace {
+    using Opcode = panda::pandasm::Opcode;
+
+    size_t g_failures = 0;
+
+    void Expect(bool condition, const std::string &test, const std::string &what)
+    {
+        if (!condition) {
+            std::cerr << test << ": " << what << std::endl;
+            g_failures++;
+        }
+    }
+
+    panda::pandasm::Ins MakeIns(Opcode opcode, std::initializer_list<uint16_t> regs = {}, const std::string &label = "")
+    {
+        panda::pandasm::Ins ins;
+        ins.opcode = opcode;
+        ins.regs = regs;
+        if (!label.empty()) {
+            ins.set_label = true;
+            ins.label = label;
+        }
+        return ins;
+    }
+
+    panda::pandasm::Function MakeFunction(std::vector<panda::pandasm::Ins> insns)
+    {
+        panda::pandasm::Function func("test", panda::pandasm::extensions::Language::ECMASCRIPT, 0, 0, "", true, 0);
+        func.ins = std::move(insns);
+        return func;
+    }
+
+    panda::pandasm::debuginfo::LocalVariable MakeVariable(uint32_t start, uint32_t length)
+    {
+        panda::pandasm::debuginfo::LocalVariable variable;
+        variable.name = "v";
+        variable.start = start;
+        variable.length = length;
+        return variable;
+    }
+
+    // opcode and registers of each instruction, the label where there is one
+    std::string Dump(const std::vector<panda::pandasm::Ins> &insns)
+    {
+        std::string dump;
+        for (const auto &ins : insns) {
+            if (ins.set_label) {
+                dump += ins.label + ": ";
+            }
+            dump += std::to_string(static_cast<int>(ins.opcode));
+            for (auto reg : ins.regs) {
+                dump += " v" + std::to_string(reg);
+            }
+            dump += "; ";
+        }
+        return dump;
+    }
+
+    void ExpectPeephole(const std::string &test, std::vector<panda::pandasm::Ins> insns,
+                        const std::vector<panda::pandasm::Ins> &expected)
+    {
+        auto func = MakeFunction(std::move(insns));
+        size_t before = func.ins.size();
+        size_t removed = panda::ts2abc::RunPeephole(func);
+        Expect(Dump(func.ins) == Dump(expected), test, "got '" + Dump(func.ins) + "', expected '" +
+            Dump(expected) + "'");
+        Expect(removed == before - func.ins.size(), test, "wrong count of removed instructions");
+    }
+
+    void TestSelfMoves()
+    {
+        ExpectPeephole("self move", {
+            MakeIns(Opcode::MOV_DYN, {1, 1}),
+            MakeIns(Opcode::MOV_DYN, {1, 2}),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::MOV_DYN, {1, 2}),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        ExpectPeephole("repeated and swapped moves", {
+            MakeIns(Opcode::MOV_DYN, {1, 2}),
+            MakeIns(Opcode::MOV_DYN, {1, 2}),
+            MakeIns(Opcode::MOV_DYN, {2, 1}),
+            MakeIns(Opcode::MOV_DYN, {2, 3}),
+        }, {
+            MakeIns(Opcode::MOV_DYN, {1, 2}),
+            MakeIns(Opcode::MOV_DYN, {2, 3}),
+        });
+    }
+
+    void TestStaLdaPairs()
+    {
+        ExpectPeephole("sta then lda of the same register", {
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        ExpectPeephole("sta twice", {
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::STA_DYN, {0}),
+        }, {
+            MakeIns(Opcode::STA_DYN, {0}),
+        });
+        ExpectPeephole("lda then sta of the same register", {
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        ExpectPeephole("sta then lda of another register", {
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {1}),
+            MakeIns(Opcode::STA_DYN, {0}),
+        }, {
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {1}),
+            MakeIns(Opcode::STA_DYN, {0}),
+        });
+    }
+
+    void TestLabels()
+    {
+        ExpectPeephole("lda at a label", {
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {0}, "L0"),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::STA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {0}, "L0"),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        ExpectPeephole("self move at a label", {
+            MakeIns(Opcode::MOV_DYN, {1, 1}, "L0"),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::MOV_DYN, {1, 1}, "L0"),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        ExpectPeephole("load before a label", {
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {1}, "L0"),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {1}, "L0"),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        ExpectPeephole("labeled load followed by a load", {
+            MakeIns(Opcode::LDA_DYN, {0}, "L0"),
+            MakeIns(Opcode::LDAI_DYN),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::LDA_DYN, {0}, "L0"),
+            MakeIns(Opcode::LDAI_DYN),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+    }
+
+    void TestDeadLoads()
+    {
+        ExpectPeephole("overwritten loads", {
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::LDAI_DYN),
+            MakeIns(Opcode::FLDAI_DYN),
+            MakeIns(Opcode::LDA_STR),
+            MakeIns(Opcode::STA_DYN, {1}),
+        }, {
+            MakeIns(Opcode::LDA_STR),
+            MakeIns(Opcode::STA_DYN, {1}),
+        });
+        ExpectPeephole("load used in between", {
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::STA_DYN, {1}),
+            MakeIns(Opcode::LDAI_DYN),
+            MakeIns(Opcode::RETURN_DYN),
+        }, {
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::STA_DYN, {1}),
+            MakeIns(Opcode::LDAI_DYN),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+    }
+
+    void ExpectVariable(const std::string &test, const panda::pandasm::debuginfo::LocalVariable &variable,
+                        uint32_t start, uint32_t length)
+    {
+        Expect(variable.start == start && variable.length == length, test, "got [" +
+            std::to_string(variable.start) + ", +" + std::to_string(variable.length) + "), expected [" +
+            std::to_string(start) + ", +" + std::to_string(length) + ")");
+    }
+
+    void TestLocalVariables()
+    {
+        // 0 lda v0 (dead), 1 lda v1, 2 sta v2, 3 lda v2 (redundant), 4 return
+        auto func = MakeFunction({
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::LDA_DYN, {1}),
+            MakeIns(Opcode::STA_DYN, {2}),
+            MakeIns(Opcode::LDA_DYN, {2}),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        func.local_variable_debug = {
+            MakeVariable(0, 5),  // the whole function
+            MakeVariable(0, 1),  // only the dead load
+            MakeVariable(1, 2),  // kept instructions only
+            MakeVariable(3, 2),  // starts at a removed instruction
+            MakeVariable(4, 1),  // the last instruction
+        };
+        size_t removed = panda::ts2abc::RunPeephole(func);
+        Expect(removed == 2, "local variables", "expected 2 removed instructions, got " + std::to_string(removed));
+        ExpectVariable("whole function", func.local_variable_debug[0], 0, 3);
+        ExpectVariable("removed range", func.local_variable_debug[1], 0, 0);
+        ExpectVariable("kept range", func.local_variable_debug[2], 0, 2);
+        ExpectVariable("range starting at a removed instruction", func.local_variable_debug[3], 2, 1);
+        ExpectVariable("range of the last instruction", func.local_variable_debug[4], 2, 1);
+    }
+
+    void TestNothingToDo()
+    {
+        auto func = MakeFunction({
+            MakeIns(Opcode::LDA_DYN, {0}),
+            MakeIns(Opcode::STA_DYN, {1}),
+            MakeIns(Opcode::RETURN_DYN),
+        });
+        func.local_variable_debug = {MakeVariable(1, 2)};
+        Expect(panda::ts2abc::RunPeephole(func) == 0, "nothing to do", "removed instructions");
+        ExpectVariable("nothing to do", func.local_variable_debug[0], 1, 2);
+    }
+}
+
+int main()
+{
+    TestSelfMoves();
+    TestStaLdaPairs();
+    TestLabels();
+    TestDeadLoads();
+    TestLocalVariables();
+    TestNothingToDo();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " peephole checks failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "peephole tests passed" << std::endl;
+    return EXIT_SUCCESS;
+}
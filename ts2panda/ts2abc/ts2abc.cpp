@@ -12,24 +12,41 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <codecvt>
 #include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <locale>
+#include <sstream>
 #include <string>
 #include <unistd.h>
+#include <unordered_set>
+#ifdef PANDA_TARGET_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
 
 #include "assembly-type.h"
 #include "assembly-program.h"
 #include "assembly-emitter.h"
 #include "json/json.h"
+#include "linker.h"
+#include "opt_memo.h"
+#include "peephole.h"
+#include "sweep.h"
 #include "ts2abc_options.h"
 #include "securec.h"
+#include "ts2abc.h"
 
 #ifdef ENABLE_BYTECODE_OPT
 #include "optimize_bytecode.h"
 #endif
 
+namespace panda::ts2abc {
 namespace {
     // pandasm definitions
     constexpr const auto LANG_EXT = panda::pandasm::extensions::Language::ECMASCRIPT;
@@ -39,6 +56,19 @@ namespace {
     int g_optLevel = 0;
     std::string g_optLogLevel = "error";
     bool g_moduleModeEnabled = false;
+    bool g_peepholeEnabled = true;
+    bool g_incrementalDelta = false;
+    std::unordered_set<std::string> g_removedFunctions;
+    std::string g_splitDebugInfoDir;
+    constexpr size_t PANDA_FILE_MAGIC_SIZE = 8;
+    bool g_timingEnabled = false;
+    struct TimingEvent {
+        const char *phase;
+        int64_t start;  // us since epoch
+        int64_t duration;  // us
+        std::vector<std::pair<const char *, size_t>> counts;
+    };
+    std::vector<TimingEvent> g_timingEvents;
     const int LOG_BUFFER_SIZE = 1024;
     const int BASE = 16;
     const int UNICODE_ESCAPE_SYMBOL_LEN = 2;
@@ -63,11 +93,9 @@ namespace {
         RECORD,
         STRING,
         LITERALBUFFER,
-        OPTIONS
+        OPTIONS,
+        REMOVED_FUNCTION
     };
-
-    const int RETURN_SUCCESS = 0;
-    const int RETURN_FAILED = 1;
 }
 
 // pandasm hellpers
@@ -195,7 +223,7 @@ static std::string ParseUnicodeEscapeString(const std::string &data)
     return newData;
 }
 
-static std::string ParseString(const std::string &data)
+std::string ParseString(const std::string &data)
 {
     if (data.find("\\u") != std::string::npos) {
         return ParseUnicodeEscapeString(data);
@@ -204,7 +232,7 @@ static std::string ParseString(const std::string &data)
     return ConvertUtf8ToMUtf8(data);
 }
 
-static void ParseLiteral(const Json::Value &literal, std::vector<panda::pandasm::LiteralArray::Literal> &literalArray)
+void ParseLiteral(const Json::Value &literal, std::vector<panda::pandasm::LiteralArray::Literal> &literalArray)
 {
     panda::pandasm::LiteralArray::Literal tagLiteral;
     panda::pandasm::LiteralArray::Literal valueLiteral;
@@ -311,7 +339,7 @@ static panda::pandasm::Record ParseRecord(const Json::Value &record)
     return pandaRecord;
 }
 
-static void ParseInstructionOpCode(const Json::Value &ins, panda::pandasm::Ins &pandaIns)
+void ParseInstructionOpCode(const Json::Value &ins, panda::pandasm::Ins &pandaIns)
 {
     // read opcode as string (can be changed in future)
     if (ins.isMember("op") && ins["op"].isString()) {
@@ -374,12 +402,18 @@ static void ParseInstructionLabel(const Json::Value &ins, panda::pandasm::Ins &p
     }
 }
 
+// debug builds keep their debug info, release builds with --split-debug-info keep it for the sidecar
+static bool IsDebugInfoKept()
+{
+    return g_debugModeEnabled || !g_splitDebugInfoDir.empty();
+}
+
 static void ParseInstructionDebugInfo(const Json::Value &ins, panda::pandasm::Ins &pandaIns)
 {
     panda::pandasm::debuginfo::Ins insDebug;
     if (ins.isMember("debug_pos_info") && ins["debug_pos_info"].isObject()) {
         auto debugPosInfo = ins["debug_pos_info"];
-        if (g_debugModeEnabled) {
+        if (IsDebugInfoKept()) {
             if (debugPosInfo.isMember("boundLeft") && debugPosInfo["boundLeft"].isInt()) {
                 insDebug.bound_left = debugPosInfo["boundLeft"].asInt();
             }
@@ -401,7 +435,7 @@ static void ParseInstructionDebugInfo(const Json::Value &ins, panda::pandasm::In
     pandaIns.ins_debug = insDebug;
 }
 
-static panda::pandasm::Ins ParseInstruction(const Json::Value &ins)
+panda::pandasm::Ins ParseInstruction(const Json::Value &ins)
 {
     panda::pandasm::Ins pandaIns;
     ParseInstructionOpCode(ins, pandaIns);
@@ -415,7 +449,7 @@ static panda::pandasm::Ins ParseInstruction(const Json::Value &ins)
 
 static int ParseVariablesDebugInfo(const Json::Value &function, panda::pandasm::Function &pandaFunc)
 {
-    if (!g_debugModeEnabled) {
+    if (!IsDebugInfoKept()) {
         return RETURN_SUCCESS;
     }
 
@@ -464,7 +498,7 @@ static int ParseSourceFileDebugInfo(const Json::Value &function, panda::pandasm:
         pandaFunc.source_file = function["sourceFile"].asString();
     }
 
-    if (g_debugModeEnabled) {
+    if (IsDebugInfoKept()) {
         if (function.isMember("sourceCode") && function["sourceCode"].isString()) {
             pandaFunc.source_code = function["sourceCode"].asString();
         }
@@ -564,6 +598,23 @@ static void ParseFunctionInstructions(const Json::Value &function, panda::pandas
     }
 }
 
+void SetPeepholeEnabled(bool enabled)
+{
+    g_peepholeEnabled = enabled;
+}
+
+static void OptimizeFunctionInstructions(panda::pandasm::Function &pandaFunc)
+{
+    // debug builds are emitted as written. The pass moves local variable ranges along with the
+    // instructions, so release builds keeping their debug info for --split-debug-info are optimized too
+    if (!g_peepholeEnabled || g_debugModeEnabled) {
+        return;
+    }
+
+    size_t removed = panda::ts2abc::RunPeephole(pandaFunc);
+    Logd("peephole removed %zu instructions from %s", removed, pandaFunc.name.c_str());
+}
+
 static void ParseFunctionLabels(const Json::Value &function, panda::pandasm::Function &pandaFunc)
 {
     if (function.isMember("labels") && function["labels"].isArray()) {
@@ -599,8 +650,9 @@ static panda::pandasm::Function ParseFunction(const Json::Value &function)
     auto pandaFunc = GetFunctionDefintion(function);
     ParseFunctionMetadata(function, pandaFunc);
     ParseFunctionInstructions(function, pandaFunc);
-    // parsing variables debug info
+    // parsing variables debug info, before the peephole pass which moves their ranges
     ParseVariablesDebugInfo(function, pandaFunc);
+    OptimizeFunctionInstructions(pandaFunc);
     // parsing source file debug info
     ParseSourceFileDebugInfo(function, pandaFunc);
     // parsing labels
@@ -703,6 +755,14 @@ static void ReplaceAllDistinct(std::string &str, const std::string &oldValue, co
     }
 }
 
+static void ParseIncrementalDelta(const Json::Value &rootValue)
+{
+    Logd("-----------------parse incremental delta-----------------");
+    if (rootValue.isMember("incremental_delta") && rootValue["incremental_delta"].isBool()) {
+        g_incrementalDelta = rootValue["incremental_delta"].asBool();
+    }
+}
+
 static void ParseOptions(const Json::Value &rootValue, panda::pandasm::Program &prog)
 {
     ParseModuleMode(rootValue, prog);
@@ -710,6 +770,7 @@ static void ParseOptions(const Json::Value &rootValue, panda::pandasm::Program &
     ParseDebugMode(rootValue);
     ParseOptLevel(rootValue);
     ParseOptLogLevel(rootValue);
+    ParseIncrementalDelta(rootValue);
 }
 
 static void ParseSingleFunc(const Json::Value &rootValue, panda::pandasm::Program &prog)
@@ -742,13 +803,23 @@ static void ParseSingleLiteralBuf(const Json::Value &rootValue, panda::pandasm::
     prog.literalarray_table.emplace(std::to_string(g_literalArrayCount++), std::move(literalarrayInstance));
 }
 
-static int ParseSmallPieceJson(const std::string &subJson, panda::pandasm::Program &prog)
+static void ParseRemovedFunction(const Json::Value &rootValue)
+{
+    g_removedFunctions.insert(rootValue["func_name"].asString());
+}
+
+int ParseSmallPieceJson(const std::string &subJson, panda::pandasm::Program &prog)
 {
     Json::Value rootValue;
-    if (ParseJson(subJson, rootValue)) {
-        std::cerr <<" Fail to parse json by JsonCPP" << std::endl;
-        return RETURN_FAILED;
+    {
+        ScopedMemStat memStat("parse json");
+        if (ParseJson(subJson, rootValue)) {
+            std::cerr <<" Fail to parse json by JsonCPP" << std::endl;
+            return RETURN_FAILED;
+        }
     }
+    // the jsoncpp tree of one piece is freed before the next, only the program grows
+    ScopedMemStat memStat("build program");
     int type = -1;
     if (rootValue.isMember("type") && rootValue["type"].isInt()) {
         type = rootValue["type"].asInt();
@@ -782,6 +853,12 @@ static int ParseSmallPieceJson(const std::string &subJson, panda::pandasm::Progr
             ParseOptions(rootValue, prog);
             break;
         }
+        case JsonType::REMOVED_FUNCTION: {
+            if (rootValue.isMember("func_name") && rootValue["func_name"].isString()) {
+                ParseRemovedFunction(rootValue);
+            }
+            break;
+        }
         default: {
             std::cerr << "Unreachable json type: " << type << std::endl;
             return RETURN_FAILED;
@@ -790,28 +867,21 @@ static int ParseSmallPieceJson(const std::string &subJson, panda::pandasm::Progr
     return RETURN_SUCCESS;
 }
 
-static bool ParseData(const std::string &data, panda::pandasm::Program &prog)
+// Calls 'handler' on every raw piece between a pair of unescaped '$', escaped "#$" are kept as is
+bool ForEachPiece(const std::string &data, const std::function<bool(const std::string &)> &handler)
 {
-    if (data.empty()) {
-        std::cerr << "the stringify json is empty" << std::endl;
-        return false;
-    }
-
     size_t pos = 0;
     bool isStartDollar = true;
 
     for (size_t idx = 0; idx < data.size(); idx++) {
-        if (data[idx] == '$' && data[idx - 1] != '#') {
+        if (data[idx] == '$' && (idx == 0 || data[idx - 1] != '#')) {
             if (isStartDollar) {
                 pos = idx + 1;
                 isStartDollar = false;
                 continue;
             }
 
-            std::string subJson = data.substr(pos, idx - pos);
-            ReplaceAllDistinct(subJson, "#$", "$");
-            if (ParseSmallPieceJson(subJson, prog)) {
-                std::cerr << "fail to parse stringify json" << std::endl;
+            if (!handler(data.substr(pos, idx - pos))) {
                 return false;
             }
             isStartDollar = true;
@@ -821,56 +891,39 @@ static bool ParseData(const std::string &data, panda::pandasm::Program &prog)
     return true;
 }
 
-static bool GenerateProgram(const std::string &data, std::string output,
-                           panda::PandArg<int> optLevelArg,
-                           panda::PandArg<std::string> optLogLevelArg)
+bool ParseData(const std::string &data, panda::pandasm::Program &prog)
 {
-    panda::pandasm::Program prog = panda::pandasm::Program();
-    prog.lang = panda::pandasm::extensions::Language::ECMASCRIPT;
-    if (!ParseData(data, prog)) {
-        std::cerr << "fail to parse Data!" << std::endl;
+    if (data.empty()) {
+        std::cerr << "the stringify json is empty" << std::endl;
         return false;
     }
 
-    Logd("parsing done, calling pandasm\n");
-
-#ifdef ENABLE_BYTECODE_OPT
-    if (g_optLevel != O_LEVEL0 || optLevelArg.GetValue() != O_LEVEL0) {
-        std::string optLogLevel = (optLogLevelArg.GetValue() != "error") ? optLogLevelArg.GetValue() : g_optLogLevel;
-
-        const uint32_t componentMask = panda::Logger::Component::CLASS2PANDA | panda::Logger::Component::ASSEMBLER |
-                                    panda::Logger::Component::BYTECODE_OPTIMIZER | panda::Logger::Component::COMPILER;
-        panda::Logger::InitializeStdLogging(panda::Logger::LevelFromString(optLogLevel), componentMask);
-
-        bool emitDebugInfo = true;
-        std::map<std::string, size_t> stat;
-        std::map<std::string, size_t> *statp = nullptr;
-        panda::pandasm::AsmEmitter::PandaFileToPandaAsmMaps maps {};
-        panda::pandasm::AsmEmitter::PandaFileToPandaAsmMaps* mapsp = &maps;
-
-        if (!panda::pandasm::AsmEmitter::Emit(output.c_str(), prog, statp, mapsp, emitDebugInfo)) {
-            std::cerr << "Failed to emit binary data: " << panda::pandasm::AsmEmitter::GetLastError() << std::endl;
-            return false;
-        }
-        panda::bytecodeopt::OptimizeBytecode(&prog, mapsp, output.c_str(), true);
-        if (!panda::pandasm::AsmEmitter::Emit(output.c_str(), prog, statp, mapsp, emitDebugInfo)) {
-            std::cerr << "Failed to emit binary data: " << panda::pandasm::AsmEmitter::GetLastError() << std::endl;
+    // literal array ids are per program
+    g_literalArrayCount = 0;
+    return ForEachPiece(data, [&prog](const std::string &piece) {
+        std::string subJson = piece;
+        ReplaceAllDistinct(subJson, "#$", "$");
+        if (ParseSmallPieceJson(subJson, prog)) {
+            std::cerr << "fail to parse stringify json" << std::endl;
             return false;
         }
         return true;
-    }
-#endif
-
-    if (!panda::pandasm::AsmEmitter::Emit(output.c_str(), prog, nullptr)) {
-        std::cerr << "Failed to emit binary data" << std::endl;
-        return false;
-    }
+    });
+}
 
-    Logd("Successfully generated: %s\n", output.c_str());
-    return true;
+void ResetParseState()
+{
+    g_moduleModeEnabled = false;
+    g_debugLogEnabled = false;
+    g_debugModeEnabled = false;
+    g_optLevel = 0;
+    g_optLogLevel = "error";
+    g_incrementalDelta = false;
+    g_removedFunctions.clear();
+    g_literalArrayCount = 0;
 }
 
-static bool HandleJsonFile(const std::string &input, std::string &data)
+bool HandleJsonFile(const std::string &input, std::string &data)
 {
     auto inputAbs = panda::os::file::File::GetAbsolutePath(input);
     if (!inputAbs) {
@@ -895,7 +948,7 @@ static bool HandleJsonFile(const std::string &input, std::string &data)
     file.seekg(0, std::ios::beg);
     auto buf = std::vector<char>(fileSize);
     file.read(reinterpret_cast<char *>(buf.data()), fileSize);
-    data = buf.data();
+    data.assign(buf.data(), static_cast<size_t>(file.gcount()));
     buf.clear();
     file.close();
     Logd(data.c_str());
@@ -904,7 +957,7 @@ static bool HandleJsonFile(const std::string &input, std::string &data)
     return true;
 }
 
-static bool ReadFromPipe(std::string &data)
+bool ReadFromPipe(std::string &data)
 {
     const size_t bufSize = 4096;
     const size_t fd = 3;
@@ -930,100 +983,475 @@ static bool ReadFromPipe(std::string &data)
     return true;
 }
 
-int main(int argc, const char *argv[])
-{
-    panda::PandArgParser argParser;
-    panda::Span<const char *> sp(argv, argc);
-    panda::ts2abc::Options options(sp[0]);
-    options.AddOptions(&argParser);
-
-    panda::PandArg<bool> sizeStatArg("size-stat", false, "Print panda file size statistic");
-    argParser.Add(&sizeStatArg);
-    panda::PandArg<bool> helpArg("help", false, "Print this message and exit");
-    argParser.Add(&helpArg);
-    panda::PandArg<int> optLevelArg("opt-level", 0,
-        "Optimization level. Possible values: [0, 1, 2]. Default: 0\n    0: no optimizations\n    "
-        "1: basic bytecode optimizations, including valueNumber, lowering, constantResolver, regAccAllocator\n    "
-        "2: (experimental optimizations): Sta/Lda Peephole, Movi/Lda Peephole, Register Coalescing");
-    argParser.Add(&optLevelArg);
-    panda::PandArg<std::string> optLogLevelArg("opt-log-level", "error",
-        "Optimization log level. Possible values: ['error', 'debug', 'info', 'fatal']. Default: 'error' ");
-    argParser.Add(&optLogLevelArg);
-    panda::PandArg<bool> bcVersionArg("bc-version", false, "Print ark bytecode version");
-    argParser.Add(&bcVersionArg);
-    panda::PandArg<bool> bcMinVersionArg("bc-min-version", false, "Print ark bytecode minimum supported version");
-    argParser.Add(&bcMinVersionArg);
-    panda::PandArg<bool> compileByPipeArg("compile-by-pipe", false, "Compile a json file that is passed by pipe");
-    argParser.Add(&compileByPipeArg);
-
-    argParser.EnableTail();
-
-    panda::PandArg<std::string> tailArg1("ARG_1", "", "Path to input(json file) or path to output(ark bytecode)" \
-        " when 'compile-by-pipe' enabled");
-    panda::PandArg<std::string> tailArg2("ARG_2", "", "Path to output(ark bytecode) or ignore when 'compile-by-pipe'" \
-        " enabled");
-    argParser.PushBackTail(&tailArg1);
-    argParser.PushBackTail(&tailArg2);
-
-    if (!argParser.Parse(argc, argv)) {
-        std::cerr << argParser.GetErrorString();
-        std::cerr << argParser.GetHelpString();
-        return RETURN_FAILED;
+static bool WaitForPipeClosed()
+{
+    const size_t bufSize = 4096;
+    const size_t fd = 3;
+
+    char buff[bufSize];
+    int ret = 0;
+
+    // the frontend closes the pipe once the whole program has been written into the shared file
+    while ((ret = read(fd, buff, bufSize)) != 0) {
+        if (ret < 0) {
+            std::cerr << "Read pipe error" << std::endl;
+            return false;
+        }
     }
 
-    std::string usage = "Usage: ts2abc [OPTIONS]... [ARGS]...";
-    if (helpArg.GetValue()) {
-        std::cout << usage << std::endl;
-        std::cout << argParser.GetHelpString();
-        return RETURN_SUCCESS;
+    return true;
+}
+
+bool ReadFromSharedFile(const std::string &shmFile, std::string &data)
+{
+    if (!WaitForPipeClosed()) {
+        return false;
     }
 
-    if (bcVersionArg.GetValue() || bcMinVersionArg.GetValue()) {
-        std::string version = bcVersionArg.GetValue() ? panda::panda_file::GetVersion(panda::panda_file::version) :
-            panda::panda_file::GetVersion(panda::panda_file::minVersion);
-        std::cout << version << std::endl;
-        return RETURN_SUCCESS;
+#ifdef PANDA_TARGET_UNIX
+    int fd = open(shmFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "failed to open shared file: " << shmFile << std::endl;
+        return false;
     }
+    // the name is not needed any more, the open fd keeps the content alive
+    unlink(shmFile.c_str());
 
-    if ((optLevelArg.GetValue() < O_LEVEL0) || (optLevelArg.GetValue() > O_LEVEL2)) {
-        std::cerr << "Incorrect optimization level value" << std::endl;
-        std::cerr << usage << std::endl;
-        std::cerr << argParser.GetHelpString();
-        return RETURN_FAILED;
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "Nothing has been written to shared file" << std::endl;
+        close(fd);
+        return false;
     }
 
-    std::string input, output;
-    std::string data = "";
+    // read straight into 'data', which is parsed in place, so the content is held in memory only once
+    size_t size = static_cast<size_t>(st.st_size);
+    data.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t ret = read(fd, &data[done], size - done);
+        if (ret <= 0) {
+            std::cerr << "failed to read shared file: " << shmFile << std::endl;
+            close(fd);
+            return false;
+        }
+        done += static_cast<size_t>(ret);
+    }
+    close(fd);
+#else
+    if (!HandleJsonFile(shmFile, data)) {
+        return false;
+    }
+    std::remove(shmFile.c_str());
+#endif
 
-    if (!compileByPipeArg.GetValue()) {
-        input = tailArg1.GetValue();
-        output = tailArg2.GetValue();
-        if (input.empty() || output.empty()) {
-            std::cerr << "Incorrect args number" << std::endl;
-            std::cerr << "Usage example: ts2abc test.json test.abc\n" << std::endl;
-            std::cerr << usage << std::endl;
-            std::cerr << argParser.GetHelpString();
-            return RETURN_FAILED;
+    Logd("finish reading from shared file");
+    return true;
+}
+
+// Completes a delta piece stream with the functions of the previous build which were neither
+// resent nor removed, counted in 'reused'. Everything but functions is always resent by the frontend.
+static bool MergeIncrementalCache(const std::string &cacheFile, const std::string &data,
+                                  panda::pandasm::Program &prog, std::string &cacheData, size_t &reused)
+{
+    cacheData = data;
+    if (!g_incrementalDelta) {
+        return true;
+    }
+
+    std::string baseData;
+    if (!panda::os::file::File::IsRegularFile(cacheFile) || !HandleJsonFile(cacheFile, baseData)) {
+        std::cerr << "incremental cache is missing, a full build is required: " << cacheFile << std::endl;
+        return false;
+    }
+
+    bool res = ForEachPiece(baseData, [&](const std::string &piece) {
+        std::string subJson = piece;
+        ReplaceAllDistinct(subJson, "#$", "$");
+        Json::Value rootValue;
+        if (ParseJson(subJson, rootValue)) {
+            std::cerr << "fail to parse incremental cache" << std::endl;
+            return false;
         }
-        if (!HandleJsonFile(input, data)) {
-            return RETURN_FAILED;
+
+        if (!rootValue.isMember("type") || !rootValue["type"].isInt() ||
+            rootValue["type"].asInt() != JsonType::FUNCTION || !rootValue["func_body"].isObject()) {
+            return true;
         }
-    } else {
-        output = tailArg1.GetValue();
-        if (output.empty()) {
-            std::cerr << usage << std::endl;
-            std::cerr << argParser.GetHelpString();
-            return RETURN_FAILED;
+
+        std::string funcName = rootValue["func_body"]["name"].asString();
+        if (prog.function_table.find(funcName) != prog.function_table.end() ||
+            g_removedFunctions.find(funcName) != g_removedFunctions.end()) {
+            return true;
         }
-        if (!ReadFromPipe(data)) {
-            return RETURN_FAILED;
+
+        ParseSingleFunc(rootValue, prog);
+        cacheData += "$" + piece + "$\n";
+        reused++;
+        return true;
+    });
+
+    Logd("incremental build reused %zu functions", reused);
+    return res;
+}
+
+static void SaveIncrementalCache(const std::string &cacheFile, const std::string &cacheData)
+{
+    // write aside and rename, so that an interrupted build never leaves a truncated cache
+    std::string tmpFile = cacheFile + ".tmp";
+    std::ofstream file(tmpFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "failed to write incremental cache: " << tmpFile << std::endl;
+        return;
+    }
+    file.write(cacheData.data(), cacheData.size());
+    file.close();
+
+    if (std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0) {
+        std::cerr << "failed to update incremental cache: " << cacheFile << std::endl;
+        std::remove(tmpFile.c_str());
+    }
+}
+
+void SetSplitDebugInfo(const std::string &sidecarDir)
+{
+    g_splitDebugInfoDir = sidecarDir;
+}
+
+// Moves what only a debugger needs out of 'prog': local variables, source code and columns.
+// Line numbers stay, stack traces need them.
+static Json::Value SplitDebugInfo(panda::pandasm::Program &prog)
+{
+    Json::Value functions(Json::objectValue);
+    for (auto &[name, func] : prog.function_table) {
+        Json::Value function;
+        function["source_file"] = func.source_file;
+        function["source_code"] = func.source_code;
+        func.source_code.clear();
+
+        Json::Value variables(Json::arrayValue);
+        for (const auto &variableDebug : func.local_variable_debug) {
+            Json::Value variable;
+            variable["name"] = variableDebug.name;
+            variable["signature"] = variableDebug.signature;
+            variable["signature_type"] = variableDebug.signature_type;
+            variable["reg"] = variableDebug.reg;
+            variable["start"] = variableDebug.start;
+            variable["length"] = variableDebug.length;
+            variables.append(variable);
+        }
+        function["variables"] = variables;
+        func.local_variable_debug.clear();
+
+        // [bound_left, bound_right] of every instruction, in order
+        Json::Value columns(Json::arrayValue);
+        for (auto &ins : func.ins) {
+            Json::Value column(Json::arrayValue);
+            column.append(static_cast<Json::UInt64>(ins.ins_debug.bound_left));
+            column.append(static_cast<Json::UInt64>(ins.ins_debug.bound_right));
+            columns.append(column);
+            ins.ins_debug.bound_left = 0;
+            ins.ins_debug.bound_right = 0;
+            ins.ins_debug.whole_line.clear();
         }
+        function["columns"] = columns;
+        functions[name] = function;
     }
+    return functions;
+}
 
-    if (!GenerateProgram(data, output, optLevelArg, optLogLevelArg)) {
-        std::cerr << "call GenerateProgram fail" << std::endl;
-        return RETURN_FAILED;
+// The sidecar is named after the checksum in the header of 'output', which is how a debugger finds it
+static bool WriteDebugInfoSidecar(const std::string &output, const Json::Value &functions)
+{
+    std::ifstream abc(output, std::ios::in | std::ios::binary);
+    uint32_t checksum = 0;
+    abc.seekg(PANDA_FILE_MAGIC_SIZE);
+    if (!abc.read(reinterpret_cast<char *>(&checksum), sizeof(checksum))) {
+        std::cerr << "failed to read the checksum of " << output << std::endl;
+        return false;
     }
 
-    return RETURN_SUCCESS;
+    std::stringstream key;
+    key << std::hex << std::setw(sizeof(checksum) * 2) << std::setfill('0') << checksum;
+    Json::Value root;
+    root["checksum"] = key.str();
+    root["abc"] = output;
+    root["functions"] = functions;
+
+    std::string sidecar = g_splitDebugInfoDir + "/" + key.str() + ".debug.json";
+    std::ofstream file(sidecar, std::ios::out | std::ios::trunc);
+    if (!file) {
+        std::cerr << "failed to write debug info: " << sidecar << std::endl;
+        return false;
+    }
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    file << Json::writeString(builder, root);
+    Logd("debug info of %s split into %s", output.c_str(), sidecar.c_str());
+    return true;
+}
+
+// The last emit of 'prog', the one whose output is kept
+static bool EmitOutput(const std::string &output, panda::pandasm::Program &prog,
+                       std::map<std::string, size_t> *statp,
+                       panda::pandasm::AsmEmitter::PandaFileToPandaAsmMaps *mapsp, bool emitDebugInfo)
+{
+    {
+        ScopedTiming timing("sweep");
+        auto stat = SweepDeadEntries(prog);
+        Logd("sweep removed %zu strings and %zu literal arrays, about %zu bytes", stat.strings,
+             stat.literalArrays, stat.bytes);
+        timing.AddCount("removed strings", stat.strings);
+        timing.AddCount("removed literal arrays", stat.literalArrays);
+        timing.AddCount("removed bytes", stat.bytes);
+    }
+
+    Json::Value debugInfo;
+    if (!g_splitDebugInfoDir.empty()) {
+        debugInfo = SplitDebugInfo(prog);
+    }
+
+    {
+        ScopedTiming timing("emit");
+        if (!panda::pandasm::AsmEmitter::Emit(output.c_str(), prog, statp, mapsp, emitDebugInfo)) {
+            std::cerr << "Failed to emit binary data: " << panda::pandasm::AsmEmitter::GetLastError() << std::endl;
+            return false;
+        }
+    }
+
+    RecordFunctionMemory(prog);
+    if (g_splitDebugInfoDir.empty()) {
+        return true;
+    }
+    ScopedTiming timing("split debug info");
+    return WriteDebugInfoSidecar(output, debugInfo);
+}
+
+static bool EmitProgram(const std::string &output, panda::pandasm::Program &prog,
+                        panda::PandArg<int> optLevelArg,
+                        panda::PandArg<std::string> optLogLevelArg)
+{
+#ifdef ENABLE_BYTECODE_OPT
+    if (g_optLevel != O_LEVEL0 || optLevelArg.GetValue() != O_LEVEL0) {
+        std::string optLogLevel = (optLogLevelArg.GetValue() != "error") ? optLogLevelArg.GetValue() : g_optLogLevel;
+
+        const uint32_t componentMask = panda::Logger::Component::CLASS2PANDA | panda::Logger::Component::ASSEMBLER |
+                                    panda::Logger::Component::BYTECODE_OPTIMIZER | panda::Logger::Component::COMPILER;
+        panda::Logger::InitializeStdLogging(panda::Logger::LevelFromString(optLogLevel), componentMask);
+
+        bool emitDebugInfo = true;
+        std::map<std::string, size_t> stat;
+        std::map<std::string, size_t> *statp = nullptr;
+        panda::pandasm::AsmEmitter::PandaFileToPandaAsmMaps maps {};
+        panda::pandasm::AsmEmitter::PandaFileToPandaAsmMaps* mapsp = &maps;
+
+        // debug info is per function, it cannot be shared
+        OptimizationMemo memo;
+        if (!g_debugModeEnabled) {
+            memo.SetAside(prog);
+        }
+        {
+            ScopedTiming timing("emit");
+            if (!panda::pandasm::AsmEmitter::Emit(output.c_str(), prog, statp, mapsp, emitDebugInfo)) {
+                std::cerr << "Failed to emit binary data: " << panda::pandasm::AsmEmitter::GetLastError() << std::endl;
+                return false;
+            }
+        }
+        {
+            ScopedTiming timing("optimize");
+            panda::bytecodeopt::OptimizeBytecode(&prog, mapsp, output.c_str(), true);
+            memo.Restore(prog);
+            Logd("optimized %zu functions as a copy of an identical one", memo.GetSavedCount());
+            timing.AddCount("functions copied from an identical one", memo.GetSavedCount());
+        }
+        return EmitOutput(output, prog, statp, mapsp, emitDebugInfo);
+    }
+#endif
+
+    if (!EmitOutput(output, prog, nullptr, nullptr, false)) {
+        return false;
+    }
+
+    Logd("Successfully generated: %s\n", output.c_str());
+    return true;
+}
+
+void EnableTiming()
+{
+    g_timingEnabled = true;
+}
+
+ScopedTiming::ScopedTiming(const char *phase) : phase_(phase), memStat_(phase)
+{
+    if (g_timingEnabled) {
+        start_ = std::chrono::system_clock::now();
+        steadyStart_ = std::chrono::steady_clock::now();
+    }
+}
+
+ScopedTiming::~ScopedTiming()
+{
+    if (!g_timingEnabled) {
+        return;
+    }
+
+    auto duration = std::chrono::steady_clock::now() - steadyStart_;
+    g_timingEvents.push_back({phase_,
+        std::chrono::duration_cast<std::chrono::microseconds>(start_.time_since_epoch()).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), std::move(counts_)});
+}
+
+void ScopedTiming::AddCount(const char *name, size_t value)
+{
+    if (g_timingEnabled) {
+        counts_.emplace_back(name, value);
+    }
+}
+
+bool WriteTimingFile(const std::string &timingFile)
+{
+    Json::Value events(Json::arrayValue);
+    for (const auto &timingEvent : g_timingEvents) {
+        Json::Value event;
+        event["name"] = timingEvent.phase;
+        event["cat"] = "ts2abc";
+        event["ph"] = "X";
+        event["ts"] = static_cast<Json::Int64>(timingEvent.start);
+        event["dur"] = static_cast<Json::Int64>(timingEvent.duration);
+        event["pid"] = static_cast<Json::Int64>(getpid());
+        event["tid"] = 0;
+        for (const auto &[name, value] : timingEvent.counts) {
+            event["args"][name] = static_cast<Json::UInt64>(value);
+        }
+        events.append(event);
+    }
+
+    Json::Value root;
+    root["traceEvents"] = events;
+    std::ofstream file(timingFile, std::ios::out | std::ios::trunc);
+    if (!file) {
+        std::cerr << "failed to write timing file: " << timingFile << std::endl;
+        return false;
+    }
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    file << Json::writeString(builder, root);
+    return true;
+}
+
+bool GenerateProgram(const std::string &data, std::string output,
+                     panda::PandArg<int> optLevelArg,
+                     panda::PandArg<std::string> optLogLevelArg,
+                     const std::string &incrementalCache)
+{
+    panda::pandasm::Program prog = panda::pandasm::Program();
+    prog.lang = panda::pandasm::extensions::Language::ECMASCRIPT;
+    {
+        ScopedTiming timing("parse");
+        if (!ParseData(data, prog)) {
+            std::cerr << "fail to parse Data!" << std::endl;
+            return false;
+        }
+    }
+
+    std::string cacheData;
+    if (!incrementalCache.empty()) {
+        ScopedTiming timing("merge incremental cache");
+        size_t reused = 0;
+        if (!MergeIncrementalCache(incrementalCache, data, prog, cacheData, reused)) {
+            std::cerr << "fail to merge incremental cache!" << std::endl;
+            return false;
+        }
+        timing.AddCount("reused functions", reused);
+    }
+
+    Logd("parsing done, calling pandasm\n");
+
+    if (!EmitProgram(output, prog, optLevelArg, optLogLevelArg)) {
+        return false;
+    }
+
+    if (!incrementalCache.empty()) {
+        ScopedTiming timing("save incremental cache");
+        SaveIncrementalCache(incrementalCache, cacheData);
+    }
+
+    return true;
+}
+
+static bool ParseLinkList(const std::string &linkList, std::vector<std::pair<std::string, std::string>> &modules)
+{
+    std::ifstream file(linkList);
+    if (!file) {
+        std::cerr << "failed to open link list: " << linkList << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        auto tab = line.find('\t');
+        if (tab == std::string::npos) {
+            std::cerr << "malformed line in link list, '<module name>\\t<piece file>' expected: " << line << std::endl;
+            return false;
+        }
+        modules.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+    }
+
+    if (modules.empty()) {
+        std::cerr << "nothing to link in " << linkList << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool LinkProgram(const std::string &linkList, std::string output,
+                 panda::PandArg<int> optLevelArg,
+                 panda::PandArg<std::string> optLogLevelArg)
+{
+    std::vector<std::pair<std::string, std::string>> modules;
+    if (!ParseLinkList(linkList, modules)) {
+        return false;
+    }
+
+    panda::pandasm::Program prog = panda::pandasm::Program();
+    prog.lang = panda::pandasm::extensions::Language::ECMASCRIPT;
+    ModuleLinker linker(prog);
+    bool moduleMode = false;
+    for (const auto &[moduleName, pieceFile] : modules) {
+        std::string data;
+        if (!HandleJsonFile(pieceFile, data)) {
+            return false;
+        }
+
+        panda::pandasm::Program module = panda::pandasm::Program();
+        module.lang = panda::pandasm::extensions::Language::ECMASCRIPT;
+        g_moduleModeEnabled = false;
+        {
+            ScopedTiming timing("parse");
+            if (!ParseData(data, module)) {
+                std::cerr << "fail to parse Data of " << moduleName << std::endl;
+                return false;
+            }
+        }
+
+        // there is a single _ESModuleMode record per file
+        if (linker.GetStatistics().modules > 0 && g_moduleModeEnabled != moduleMode) {
+            std::cerr << "cannot link modules and scripts into one file: " << moduleName << std::endl;
+            return false;
+        }
+        moduleMode = g_moduleModeEnabled;
+
+        ScopedTiming timing("link");
+        linker.AddModule(module, moduleName);
+    }
+
+    const auto &stat = linker.GetStatistics();
+    Logd("linked %zu modules, strings: %zu -> %zu, literal arrays: %zu -> %zu", stat.modules,
+         stat.strings, prog.strings.size(), stat.literalArrays, prog.literalarray_table.size());
+
+    return EmitProgram(output, prog, optLevelArg, optLogLevelArg);
 }
+} // namespace panda::ts2abc
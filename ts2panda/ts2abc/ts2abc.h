@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PANDA_TS2ABC_TS2ABC_H_
+#define PANDA_TS2ABC_TS2ABC_H_
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "assembly-program.h"
+#include "json/json.h"
+#include "mem_stat.h"
+#include "utils/pandargs.h"
+
+namespace panda::ts2abc {
+constexpr int RETURN_SUCCESS = 0;
+constexpr int RETURN_FAILED = 1;
+
+// input
+bool HandleJsonFile(const std::string &input, std::string &data);
+bool ReadFromPipe(std::string &data);
+bool ReadFromSharedFile(const std::string &shmFile, std::string &data);
+
+// whole compilation: parse the piece stream, build the program and emit it to 'output'
+bool GenerateProgram(const std::string &data, std::string output,
+                     panda::PandArg<int> optLevelArg,
+                     panda::PandArg<std::string> optLogLevelArg,
+                     const std::string &incrementalCache);
+void SetPeepholeEnabled(bool enabled);
+// write local variables, source code and columns to '<sidecarDir>/<checksum>.debug.json' instead of the output
+void SetSplitDebugInfo(const std::string &sidecarDir);
+
+// link mode: merge the piece streams listed in 'linkList', one "<module name>\t<piece file>" per line,
+// into a single program. The first module is the entry of the file.
+bool LinkProgram(const std::string &linkList, std::string output,
+                 panda::PandArg<int> optLevelArg,
+                 panda::PandArg<std::string> optLogLevelArg);
+
+// phase timing, written as chrome trace events so that it merges with the frontend's trace.
+// With --mem-stat every timed phase is accounted for memory as well. Counts added to a phase are
+// written as the args of its event, the frontend prints them with its timing report.
+void EnableTiming();
+bool WriteTimingFile(const std::string &timingFile);
+
+class ScopedTiming {
+public:
+    explicit ScopedTiming(const char *phase);
+    ~ScopedTiming();
+    ScopedTiming(const ScopedTiming &) = delete;
+    ScopedTiming &operator=(const ScopedTiming &) = delete;
+
+    void AddCount(const char *name, size_t value);
+
+private:
+    const char *phase_;
+    ScopedMemStat memStat_;
+    std::vector<std::pair<const char *, size_t>> counts_;
+    std::chrono::system_clock::time_point start_;
+    std::chrono::steady_clock::time_point steadyStart_;
+};
+
+// parsing stages, exposed for the benchmarks
+bool ForEachPiece(const std::string &data, const std::function<bool(const std::string &)> &handler);
+bool ParseData(const std::string &data, panda::pandasm::Program &prog);
+// back to the state of a fresh process: the options and removed functions of a stream are global
+void ResetParseState();
+int ParseSmallPieceJson(const std::string &subJson, panda::pandasm::Program &prog);
+panda::pandasm::Ins ParseInstruction(const Json::Value &ins);
+void ParseInstructionOpCode(const Json::Value &ins, panda::pandasm::Ins &pandaIns);
+std::string ParseString(const std::string &data);
+void ParseLiteral(const Json::Value &literal, std::vector<panda::pandasm::LiteralArray::Literal> &literalArray);
+} // namespace panda::ts2abc
+
+#endif // PANDA_TS2ABC_TS2ABC_H_